@@ -0,0 +1,273 @@
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <nlohmann/json.hpp>
+
+#include "core/Film.h"
+#include "core/Integrator.h"
+#include "core/Sampler.h"
+#include "core/TRay.h"
+#include "core/fileio.h"
+#include "core/imageio.h"
+#include "loaders/KeyVal.h"
+#include "loaders/SceneLoader.h"
+
+using namespace TRay;
+using namespace std;
+using json = nlohmann::json;
+
+/**
+ * Usage: TRay-Bench <scene file> [--spp a,b,...] [--samplers a,b,...]
+ *                   [--reference-spp n] [--out file]
+ *
+ * Renders the scene with each sampler at each spp, and writes JSON with the
+ * RMSE against a reference and the render time of every run, plus the raw
+ * sample generation speed of each sampler.
+ *
+ * The reference is the second half of a Sobol' render with twice the
+ * reference spp, so it shares no samples with the Sobol' runs. It is
+ * rendered once and kept in <scene file>.ref<n>.trfilm, until the scene file
+ * or a mesh file changes.
+ *
+ * Run from the directory the scene paths are relative to, as TRay-CLI.
+ */
+namespace {
+struct Options {
+  string scene_path;
+  vector<int> spps = {1, 4, 16, 64, 256};
+  vector<string> samplers = {
+      Val::StratifiedSampler, Val::RandomSampler,    Val::HaltonSampler,
+      Val::ZeroTwoSampler,    Val::MaxMinDisSampler, Val::SobolSampler,
+      Val::ZSobolSampler};
+  int reference_spp = 4096;
+  string out_path;
+};
+// Dimension counts of the sample generation speed test.
+const int kThroughputDims[] = {2, 8, 32};
+
+vector<string> split(const string &s) {
+  vector<string> items;
+  size_t begin = 0;
+  while (begin <= s.size()) {
+    size_t end = s.find(',', begin);
+    if (end == string::npos) end = s.size();
+    if (end > begin) items.push_back(s.substr(begin, end - begin));
+    begin = end + 1;
+  }
+  return items;
+}
+/// @brief Sampler description of @param type with @param spp, the other
+///        settings taken from @param base.
+json sampler_json(const string &type, int spp, const json &base) {
+  json sampler;
+  sampler[Key::Type] = type;
+  sampler[Key::SampleDimension] = base.value(Key::SampleDimension, 8);
+  sampler[Key::Jitter] = base.value(Key::Jitter, true);
+  if (type == Val::StratifiedSampler) {
+    // Strata as square as the spp allows.
+    int x = 1;
+    while (x * x < spp) x *= 2;
+    int y = max(1, spp / x);
+    sampler[Key::SamplePerPixel] = {x, y};
+  } else {
+    sampler[Key::SamplePerPixel] = spp;
+  }
+  return sampler;
+}
+/// @brief Load @param scene with @param sampler into @param loader, through
+///        the temporary scene file @param path.
+bool load(SceneLoader &loader, const string &path, json scene,
+          const json &sampler) {
+  scene[Key::Sampler] = sampler;
+  // Runs must not resume each other.
+  scene[Key::Camera][Key::Film].erase(Key::Checkpoint);
+  ofstream(path) << scene.dump(2);
+  return loader.reload(path.c_str());
+}
+/// @brief A scene file rewritten for the runs, removed with its snapshot
+///        when the benchmark ends.
+struct SceneCopy {
+  ~SceneCopy() {
+    error_code ec;
+    filesystem::remove(path, ec);
+    filesystem::remove(SceneSnapshot::snapshot_path(path), ec);
+  }
+  string path;
+};
+/// @brief Identity of @param scene loaded from @param scene_path and of the
+///        mesh files it uses, as the key of film checkpoints.
+uint64_t reference_key(const string &scene_path, const json &scene) {
+  vector<string> files = SceneLoader::referenced_files(scene);
+  files.push_back(scene_path);
+  return SceneSnapshot::key(0, files);
+}
+/// @brief Whether the reference at @param ref_path was rendered with
+///        @param key.
+bool reference_matches(const string &ref_path, uint64_t key) {
+  uint64_t stored = 0;
+  ifstream(ref_path + ".key", ios::binary)
+      .read(reinterpret_cast<char *>(&stored), sizeof(stored));
+  return stored == key;
+}
+/// @brief Filtered RGB values of the pixel sums @param pixels.
+vector<Float> resolve(const Pixel *pixels, size_t n) {
+  vector<Float> rgb(3 * n);
+  for (size_t i = 0; i < n; i++) {
+    Float w = pixels[i].filter_weight_sum;
+    for (int c = 0; c < 3; c++)
+      rgb[3 * i + c] = w != 0 ? pixels[i].rgb[c] / w : 0;
+  }
+  return rgb;
+}
+double rmse(const vector<Float> &a, const vector<Float> &b) {
+  double sum = 0;
+  for (size_t i = 0; i < a.size(); i++) sum += (a[i] - b[i]) * (a[i] - b[i]);
+  return sqrt(sum / a.size());
+}
+double seconds_since(chrono::steady_clock::time_point start) {
+  return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+/// @brief Sample vectors per second of @param n_dims dimensions generated by
+///        @param sampler over @param bound.
+double sample_speed(const Sampler &sampler, const Bound2i &bound, int n_dims) {
+  unique_ptr<Sampler> s = sampler.clone(0);
+  s->reserve_dimensions({0, n_dims / 2});
+  auto start = chrono::steady_clock::now();
+  int64_t n_vectors = 0;
+  Float sink = 0;
+  for (Point2i p : Bound2iIterator(bound)) {
+    s->start_pixel(p);
+    do {
+      for (int d = 0; d < n_dims; d += 2) sink += s->sample_2D().x;
+      n_vectors++;
+    } while (s->next_sample());
+  }
+  double dt = seconds_since(start);
+  // Keep the values alive.
+  if (sink < 0) cout << sink;
+  return n_vectors / dt;
+}
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  Options opt;
+  for (int i = 1; i < argc; i++) {
+    string arg = argv[i];
+    bool has_value = i + 1 < argc;
+    if (arg == "--spp" && has_value) {
+      opt.spps.clear();
+      for (const string &s : split(argv[++i])) opt.spps.push_back(stoi(s));
+    } else if (arg == "--samplers" && has_value) {
+      opt.samplers = split(argv[++i]);
+    } else if (arg == "--reference-spp" && has_value) {
+      opt.reference_spp = stoi(argv[++i]);
+    } else if (arg == "--out" && has_value) {
+      opt.out_path = argv[++i];
+    } else if (opt.scene_path.empty() && arg[0] != '-') {
+      opt.scene_path = arg;
+    } else {
+      opt.scene_path.clear();
+      break;
+    }
+  }
+  if (opt.scene_path.empty()) {
+    cout << "Usage: TRay-Bench <scene file> [--spp a,b,...] "
+            "[--samplers a,b,...] [--reference-spp n] [--out file]"
+         << endl;
+    return 1;
+  }
+  json scene;
+  try {
+    scene = json::parse(ifstream(opt.scene_path));
+  } catch (const json::exception &e) {
+    SError(string_format("Cannot parse %s: %s", opt.scene_path.c_str(),
+                         e.what()));
+    return 1;
+  }
+  const json base_sampler =
+      scene.contains(Key::Sampler) ? scene[Key::Sampler] : json::object();
+  SceneLoader loader;
+  // Concurrent benchmarks each rewrite a scene file of their own.
+  SceneCopy copy{temp_path(
+      (filesystem::temp_directory_path() / "tray-bench-scene.json").string())};
+  const string &scene_copy = copy.path;
+
+  // Reference.
+  // ----------
+  string ref_path =
+      opt.scene_path + string_format(".ref%d.trfilm", opt.reference_spp);
+  const uint64_t ref_key = reference_key(opt.scene_path, scene);
+  loader.set_sample_part(1, 2);
+  if (!load(loader, scene_copy, scene,
+            sampler_json(Val::SobolSampler, 2 * opt.reference_spp,
+                         base_sampler)))
+    return 1;
+  shared_ptr<Film> film = loader.get_camera()->m_film;
+  PartialFilmHeader header;
+  if (filesystem::exists(ref_path) && reference_matches(ref_path, ref_key) &&
+      film->add_partial(ref_path, &header)) {
+    SInfo("Using reference " + ref_path);
+  } else {
+    SInfo("Rendering reference " + ref_path);
+    loader.get_integrator()->render(*loader.get_scene());
+    if (film->write_partial(ref_path, 1, 2))
+      write_file_replacing(ref_path + ".key", &ref_key, sizeof(ref_key));
+  }
+  const size_t n_pixels = film->m_cropped_pixel_bound.area();
+  const vector<Float> reference = resolve(film->pixels(), n_pixels);
+  loader.set_sample_part(0, 1);
+
+  // Runs.
+  // -----
+  json result;
+  result["scene"] = opt.scene_path;
+  Vector2i res = film->m_cropped_pixel_bound.diagonal();
+  result["resolution"] = {res.x, res.y};
+  result["reference"] = {{"sampler", Val::SobolSampler},
+                         {"spp", opt.reference_spp},
+                         {"file", ref_path}};
+  result["samplers"] = json::array();
+  for (const string &type : opt.samplers) {
+    json entry;
+    entry["type"] = type;
+    entry["runs"] = json::array();
+    for (int spp : opt.spps) {
+      if (!load(loader, scene_copy, scene,
+                sampler_json(type, spp, base_sampler)))
+        return 1;
+      auto start = chrono::steady_clock::now();
+      loader.get_integrator()->render(*loader.get_scene());
+      double dt = seconds_since(start);
+      film = loader.get_camera()->m_film;
+      double error = rmse(resolve(film->pixels(), n_pixels), reference);
+      int64_t actual_spp = loader.get_sampler()->m_spp;
+      entry["runs"].push_back(
+          {{"spp", actual_spp}, {"seconds", dt}, {"rmse", error}});
+      SInfo(string_format("%s spp %d: %.3f s, RMSE %.6f", type.c_str(),
+                          int(actual_spp), dt, error));
+    }
+    // Speed of the sampler alone, at the middle spp.
+    entry["throughput"] = json::array();
+    if (!load(loader, scene_copy, scene,
+              sampler_json(type, opt.spps[opt.spps.size() / 2], base_sampler)))
+      return 1;
+    for (int n_dims : kThroughputDims) {
+      double speed = sample_speed(*loader.get_sampler(),
+                                  film->m_cropped_pixel_bound, n_dims);
+      entry["throughput"].push_back({{"dimensions", n_dims},
+                                     {"samples_per_second", speed},
+                                     {"values_per_second", speed * n_dims}});
+    }
+    result["samplers"].push_back(entry);
+  }
+  if (opt.out_path.empty()) {
+    cout << result.dump(2) << endl;
+  } else {
+    ofstream(opt.out_path) << result.dump(2) << endl;
+    cout << "writing into " << opt.out_path << endl;
+  }
+  return 0;
+}
@@ -0,0 +1,171 @@
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "core/TRay.h"
+#include "core/math/RNG.h"
+#include "core/math/bluenoise.h"
+#include "core/stringformat.h"
+
+using namespace TRay;
+using namespace std;
+
+/**
+ * Usage: TRay-BlueNoise <output mask> [--size n] [--channels n] [--seed n]
+ *
+ * Generates the blue-noise mask read by the "blue_noise" key of a sampler,
+ * each channel by the void and cluster method with its own random initial
+ * pattern.
+ * @see Ulichney, The void-and-cluster method for dither array generation,
+ *      1993.
+ */
+namespace {
+struct Options {
+  string out_path;
+  int size = 64;
+  int n_channels = 2;
+  uint64_t seed = 0;
+};
+// Deviation of the energy filter, in pixels.
+const double kSigma = 1.5;
+
+/// @brief Energy of the set pixels of a binary pattern, the sum of Gaussians
+///        centered at them, on the torus.
+class Energy {
+ public:
+  Energy(int size)
+      : m_size(size), m_kernel(size * size), m_field(size * size) {
+    for (int y = 0; y < size; y++)
+      for (int x = 0; x < size; x++) {
+        int dx = std::min(x, size - x), dy = std::min(y, size - y);
+        m_kernel[y * size + x] =
+            std::exp(-(dx * dx + dy * dy) / (2 * kSigma * kSigma));
+      }
+  }
+  /// @brief Add or remove, by the sign of @param w, the pixel @param i.
+  void add(int i, double w) {
+    int x0 = i % m_size, y0 = i / m_size;
+    for (int y = 0; y < m_size; y++) {
+      const double *k = &m_kernel[((y - y0 + m_size) % m_size) * m_size];
+      double *f = &m_field[y * m_size];
+      for (int x = 0; x < m_size; x++)
+        f[x] += w * k[(x - x0 + m_size) % m_size];
+    }
+  }
+  /// @brief Pixel of largest (@param largest) or smallest energy among those
+  ///        whose bit is @param bit. At least one pixel must have it.
+  int find(const vector<uint8_t> &bits, uint8_t bit, bool largest) const {
+    const int n = int(m_field.size());
+    int best = int(std::find(bits.begin(), bits.end(), bit) - bits.begin());
+    ASSERT(best < n);
+    for (int i = best + 1; i < n; i++) {
+      if (bits[i] != bit) continue;
+      if (largest ? m_field[i] > m_field[best] : m_field[i] < m_field[best])
+        best = i;
+    }
+    return best;
+  }
+
+ private:
+  int m_size;
+  vector<double> m_kernel, m_field;
+};
+
+/// @brief Ranks of one channel, @param size squared.
+vector<uint16_t> void_and_cluster(int size, RNG &rng) {
+  const int n = size * size;
+  // Initial pattern, a tenth of the pixels at random.
+  vector<uint8_t> bits(n, 0);
+  int n_ones = std::max(1, n / 10);
+  for (int placed = 0; placed < n_ones;) {
+    int i = rng.uniform_uint32(n);
+    if (bits[i]) continue;
+    bits[i] = 1;
+    placed++;
+  }
+  Energy energy(size);
+  for (int i = 0; i < n; i++)
+    if (bits[i]) energy.add(i, 1);
+  // Move the tightest cluster into the largest void until it stays.
+  while (true) {
+    int cluster = energy.find(bits, 1, true);
+    bits[cluster] = 0;
+    energy.add(cluster, -1);
+    int hole = energy.find(bits, 0, false);
+    bits[hole] = 1;
+    energy.add(hole, 1);
+    if (hole == cluster) break;
+  }
+  const vector<uint8_t> prototype = bits;
+  const Energy prototype_energy = energy;
+  vector<uint16_t> ranks(n);
+  // Ranks below the prototype, removing the tightest clusters.
+  for (int rank = n_ones - 1; rank >= 0; rank--) {
+    int cluster = energy.find(bits, 1, true);
+    bits[cluster] = 0;
+    energy.add(cluster, -1);
+    ranks[cluster] = rank;
+  }
+  // Up to half, filling the largest voids.
+  bits = prototype;
+  energy = prototype_energy;
+  int rank = n_ones;
+  for (; rank < n / 2; rank++) {
+    int hole = energy.find(bits, 0, false);
+    bits[hole] = 1;
+    energy.add(hole, 1);
+    ranks[hole] = rank;
+  }
+  // Beyond half the unset pixels are the minority, fill their tightest
+  // clusters.
+  Energy zeros(size);
+  for (int i = 0; i < n; i++)
+    if (!bits[i]) zeros.add(i, 1);
+  for (; rank < n; rank++) {
+    int cluster = zeros.find(bits, 0, true);
+    bits[cluster] = 1;
+    zeros.add(cluster, -1);
+    ranks[cluster] = rank;
+  }
+  return ranks;
+}
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  Options opt;
+  for (int i = 1; i < argc; i++) {
+    string arg = argv[i];
+    bool has_value = i + 1 < argc;
+    if (arg == "--size" && has_value) {
+      opt.size = stoi(argv[++i]);
+    } else if (arg == "--channels" && has_value) {
+      opt.n_channels = stoi(argv[++i]);
+    } else if (arg == "--seed" && has_value) {
+      opt.seed = stoull(argv[++i]);
+    } else if (opt.out_path.empty() && arg[0] != '-') {
+      opt.out_path = arg;
+    } else {
+      opt.out_path.clear();
+      break;
+    }
+  }
+  if (opt.out_path.empty() || opt.size < 2 ||
+      opt.size > BlueNoiseMask::MaxSize || opt.n_channels < 1) {
+    cout << "Usage: TRay-BlueNoise <output mask> [--size n] [--channels n] "
+            "[--seed n]"
+         << endl;
+    return 1;
+  }
+  vector<uint16_t> ranks;
+  for (int c = 0; c < opt.n_channels; c++) {
+    RNG rng(opt.seed * opt.n_channels + c);
+    vector<uint16_t> channel = void_and_cluster(opt.size, rng);
+    ranks.insert(ranks.end(), channel.begin(), channel.end());
+    SInfo(string_format("Channel %d/%d done", c + 1, opt.n_channels));
+  }
+  BlueNoiseMask mask(opt.size, opt.n_channels, std::move(ranks));
+  if (!mask.write(opt.out_path)) return 1;
+  cout << "writing into " << opt.out_path << endl;
+  return 0;
+}
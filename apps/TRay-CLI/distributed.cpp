@@ -0,0 +1,266 @@
+#include "distributed.h"
+
+#include <chrono>
+#include <cstdio>
+#include <deque>
+#include <vector>
+
+#include "core/Film.h"
+#include "core/Integrator.h"
+#include "core/TRay.h"
+
+#ifndef TRAY_ON_WINDOWS
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+namespace TRay {
+/// @brief Header of a rendered region, as written by the worker.
+struct RegionResult {
+  // x0, y0, x1, y1 of the region.
+  int32_t bound[4];
+};
+static constexpr int kRegionSize = 64;
+
+#ifdef TRAY_ON_WINDOWS
+bool render_distributed(const char *, const char *, SceneLoader &, int) {
+  SError("render_distributed: Worker processes are not supported here");
+  return false;
+}
+int run_worker(const char *, SceneLoader &) {
+  SError("run_worker: Worker processes are not supported here");
+  return 1;
+}
+#else
+int run_worker(const char *scene_path, SceneLoader &loader) {
+  if (!loader.reload(scene_path)) return 1;
+  auto scene = loader.get_scene();
+  auto integrator = loader.get_integrator();
+  std::shared_ptr<Film> film = loader.get_camera()->m_film;
+  // The coordinator hands the region out again instead.
+  integrator->set_checkpoint(nullptr);
+  char line[128];
+  RegionResult result;
+  int32_t *b = result.bound;
+  while (fgets(line, sizeof(line), stdin)) {
+    if (sscanf(line, "%d %d %d %d", &b[0], &b[1], &b[2], &b[3]) != 4) {
+      SError("run_worker: Bad request " + std::string(line));
+      return 1;
+    }
+    film->recrop(Bound2i(Point2i(b[0], b[1]), Point2i(b[2], b[3])));
+    integrator->render(*scene);
+    size_t n_pixels = film->m_cropped_pixel_bound.area();
+    if (fwrite(&result, sizeof(result), 1, stdout) != 1 ||
+        fwrite(film->pixels(), sizeof(Pixel), n_pixels, stdout) != n_pixels ||
+        fflush(stdout) != 0)
+      return 1;
+  }
+  return 0;
+}
+
+namespace {
+struct Worker {
+  pid_t pid = -1;
+  // Pipe ends for the requests and the results.
+  int to = -1, from = -1;
+  // Region being rendered, -1 if idle.
+  int region = -1;
+  // Result read so far.
+  std::vector<uint8_t> buffer;
+  size_t n_read = 0;
+};
+struct Region {
+  Bound2i bound;
+  bool done = false;
+  // Workers rendering it.
+  int n_running = 0;
+  std::chrono::steady_clock::time_point start;
+};
+}  // namespace
+
+static bool start_worker(const char *exe_path, const char *scene_path,
+                         Worker *w) {
+  int to[2], from[2];
+  if (pipe(to) != 0) return false;
+  if (pipe(from) != 0) {
+    close(to[0]);
+    close(to[1]);
+    return false;
+  }
+  // Later workers must not inherit these, or the worker never sees the end
+  // of its input.
+  for (int fd : {to[0], to[1], from[0], from[1]})
+    fcntl(fd, F_SETFD, FD_CLOEXEC);
+  pid_t pid = fork();
+  if (pid == 0) {
+    dup2(to[0], STDIN_FILENO);
+    dup2(from[1], STDOUT_FILENO);
+    char *const argv[] = {const_cast<char *>(exe_path),
+                          const_cast<char *>("--worker"),
+                          const_cast<char *>(scene_path), nullptr};
+    execvp(exe_path, argv);
+    _exit(127);
+  }
+  close(to[0]);
+  close(from[1]);
+  if (pid < 0) {
+    close(to[1]);
+    close(from[0]);
+    return false;
+  }
+  w->pid = pid;
+  w->to = to[1];
+  w->from = from[0];
+  return true;
+}
+static void stop_worker(Worker *w) {
+  if (w->pid < 0) return;
+  close(w->to);
+  close(w->from);
+  waitpid(w->pid, nullptr, 0);
+  w->pid = -1;
+}
+
+bool render_distributed(const char *exe_path, const char *scene_path,
+                        SceneLoader &loader, int n_workers) {
+  std::shared_ptr<Film> film = loader.get_camera()->m_film;
+  const Bound2i bound = film->m_cropped_pixel_bound;
+  int width = bound.diagonal().x;
+  std::vector<Region> regions;
+  for (int y = bound.p_min.y; y < bound.p_max.y; y += kRegionSize) {
+    for (int x = bound.p_min.x; x < bound.p_max.x; x += kRegionSize) {
+      Region region;
+      region.bound = Bound2i(Point2i(x, y),
+                             Point2i(std::min(x + kRegionSize, bound.p_max.x),
+                                     std::min(y + kRegionSize, bound.p_max.y)));
+      regions.push_back(region);
+    }
+  }
+  // A worker gone mid-request must not take the coordinator with it.
+  signal(SIGPIPE, SIG_IGN);
+  std::vector<Worker> workers(n_workers);
+  int n_alive = 0;
+  for (Worker &w : workers) n_alive += start_worker(exe_path, scene_path, &w);
+  SInfo(string_format("render_distributed: %d regions, %d workers",
+                      int(regions.size()), n_alive));
+
+  // Regions never handed out start at next, regions of failed workers go to
+  // retry.
+  size_t next = 0;
+  std::deque<int> retry;
+  int n_done = 0;
+  auto pick_region = [&]() {
+    while (!retry.empty()) {
+      int r = retry.front();
+      retry.pop_front();
+      if (!regions[r].done) return r;
+    }
+    if (next < regions.size()) return int(next++);
+    // Straggler, the region rendering for the longest on a single worker.
+    int oldest = -1;
+    for (int r = 0; r < int(regions.size()); r++) {
+      const Region &region = regions[r];
+      if (region.done || region.n_running != 1) continue;
+      if (oldest < 0 || region.start < regions[oldest].start) oldest = r;
+    }
+    return oldest;
+  };
+  auto fail_worker = [&](Worker &w) {
+    SWarn(string_format("render_distributed: Worker %d failed", int(w.pid)));
+    stop_worker(&w);
+    n_alive--;
+    if (w.region < 0) return;
+    Region &region = regions[w.region];
+    region.n_running--;
+    if (!region.done && region.n_running == 0) retry.push_back(w.region);
+    w.region = -1;
+  };
+  auto assign = [&](Worker &w) {
+    int r = pick_region();
+    if (r < 0) return;
+    Region &region = regions[r];
+    const Bound2i &b = region.bound;
+    if (dprintf(w.to, "%d %d %d %d\n", b.p_min.x, b.p_min.y, b.p_max.x,
+                b.p_max.y) < 0) {
+      retry.push_back(r);
+      fail_worker(w);
+      return;
+    }
+    if (region.n_running++ == 0)
+      region.start = std::chrono::steady_clock::now();
+    w.region = r;
+    w.buffer.resize(sizeof(RegionResult) + b.area() * sizeof(Pixel));
+    w.n_read = 0;
+  };
+  auto receive = [&](Worker &w) {
+    ssize_t n = read(w.from, w.buffer.data() + w.n_read,
+                     w.buffer.size() - w.n_read);
+    if (n <= 0) {
+      fail_worker(w);
+      return;
+    }
+    w.n_read += n;
+    if (w.n_read < w.buffer.size()) return;
+    Region &region = regions[w.region];
+    const Bound2i &b = region.bound;
+    RegionResult result;
+    memcpy(&result, w.buffer.data(), sizeof(result));
+    if (result.bound[0] != b.p_min.x || result.bound[1] != b.p_min.y ||
+        result.bound[2] != b.p_max.x || result.bound[3] != b.p_max.y) {
+      fail_worker(w);
+      return;
+    }
+    region.n_running--;
+    w.region = -1;
+    if (region.done) return;
+    // Stitch the region into the film, row by row.
+    const Pixel *src =
+        reinterpret_cast<const Pixel *>(w.buffer.data() + sizeof(result));
+    int region_width = b.diagonal().x;
+    for (int y = b.p_min.y; y < b.p_max.y; y++, src += region_width) {
+      Pixel *dst = film->pixels() + size_t(y - bound.p_min.y) * width +
+                   (b.p_min.x - bound.p_min.x);
+      std::copy(src, src + region_width, dst);
+    }
+    region.done = true;
+    n_done++;
+    SInfo(string_format("render_distributed: %d/%d regions", n_done,
+                        int(regions.size())));
+  };
+
+  std::vector<pollfd> fds;
+  std::vector<Worker *> polled;
+  while (n_done < int(regions.size())) {
+    for (Worker &w : workers)
+      if (w.pid >= 0 && w.region < 0) assign(w);
+    fds.clear();
+    polled.clear();
+    for (Worker &w : workers) {
+      if (w.pid < 0 || w.region < 0) continue;
+      fds.push_back({w.from, POLLIN, 0});
+      polled.push_back(&w);
+    }
+    if (fds.empty()) break;
+    if (poll(fds.data(), fds.size(), -1) < 0) continue;
+    for (size_t i = 0; i < fds.size(); i++)
+      if (fds[i].revents) receive(*polled[i]);
+  }
+  // End of input stops the workers, those still rendering a straggler are
+  // not waited for.
+  for (Worker &w : workers) {
+    if (w.pid >= 0 && w.region >= 0) kill(w.pid, SIGTERM);
+    stop_worker(&w);
+  }
+  if (n_done < int(regions.size())) {
+    SError(string_format("render_distributed: %d/%d regions rendered, no "
+                         "worker left",
+                         n_done, int(regions.size())));
+    return false;
+  }
+  return true;
+}
+#endif
+}  // namespace TRay
@@ -0,0 +1,28 @@
+/**
+ * @file distributed.h
+ * @brief Image-space distributed rendering with local worker processes.
+ *
+ * The coordinator splits the cropped pixel bound of the film into regions
+ * and starts workers, TRay-CLI --worker, connected by pipes on their
+ * stdin and stdout. Each worker loads the scene once, then for each region
+ * it reads, recrops its film, renders and writes back the pixel sums. Once
+ * no region is left to hand out, idle workers also take the regions that
+ * are still rendering elsewhere, the first result wins.
+ *
+ * Protocol, a worker reads lines "x0 y0 x1 y1" and writes for each a
+ * RegionResult followed by the Pixel array of the region, in native byte
+ * order. It exits on end of input.
+ */
+#pragma once
+#include "loaders/SceneLoader.h"
+
+namespace TRay {
+/// @brief Render the scene of @param loader, loaded from @param scene_path,
+///        into its film with @param n_workers workers started from
+///        @param exe_path.
+bool render_distributed(const char *exe_path, const char *scene_path,
+                        SceneLoader &loader, int n_workers);
+/// @brief Serve regions of @param scene_path on stdin and stdout.
+/// @return Process exit code.
+int run_worker(const char *scene_path, SceneLoader &loader);
+}  // namespace TRay
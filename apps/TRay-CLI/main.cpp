@@ -1,32 +1,65 @@
+#include <cstdio>
 #include <ctime>
 #include <iostream>
 
 #include "core/Integrator.h"
 #include "core/TRay.h"
 #include "core/imageio.h"
+#include "core/imageoutput.h"
 #include "core/statistics.h"
+#include "distributed.h"
 #include "loaders/SceneLoader.h"
 
 using namespace TRay;
 using namespace std;
 
-uint8_t image[1000 * 1000 * 3];
-
 std::string file_path;
 SceneLoader sloader;
+// Writes each image while the next scene is loaded and rendered.
+ImageOutput output;
+// With --part k/n, only part k of the samples is rendered and written as a
+// partial film, to be summed by TRay-Merge.
+int sample_part = 0, sample_parts = 1;
+// With --workers n, the image is split among n worker processes, see
+// distributed.h.
+int n_workers = 0;
+const char *exe_path = nullptr;
 void render_file(const char *);
 
 int main(int argc, char *argv[]) {
-  fill(image, image + sizeof(image), 0);
-
+  exe_path = argv[0];
+  if (argc == 3 && string(argv[1]) == "--worker")
+    return run_worker(argv[2], sloader);
   if (argc > 1) {
     for (int i = 1; i < argc; i++) {
+      if (string(argv[i]) == "--workers") {
+        if (i + 1 >= argc || sscanf(argv[i + 1], "%d", &n_workers) != 1 ||
+            n_workers < 1) {
+          SError("Usage: --workers n, with n > 0");
+          return 1;
+        }
+        i++;
+        continue;
+      }
+      if (string(argv[i]) == "--part") {
+        if (i + 1 >= argc ||
+            sscanf(argv[i + 1], "%d/%d", &sample_part, &sample_parts) != 2 ||
+            sample_parts < 1 || sample_part < 0 ||
+            sample_part >= sample_parts) {
+          SError("Usage: --part k/n, with 0 <= k < n");
+          return 1;
+        }
+        sloader.set_sample_part(sample_part, sample_parts);
+        i++;
+        continue;
+      }
       time_t st = time(NULL);
       render_file(argv[i]);
       time_t ed = time(NULL);
       SInfo(string_format("Rendering done, %d seconds used.", int(ed - st)));
       TRay::PrintStats(std::cout);
     }
+    output.wait();
     return 0;
   }
 
@@ -40,11 +73,40 @@ void render_file(const char *path) {
   }
   auto scene = sloader.get_scene();
   auto integrator = sloader.get_integrator();
+  string fname = sloader.get_camera()->m_film->m_filename;
+  if (n_workers > 0) {
+    if (sample_parts > 1) {
+      SError("--part and --workers can not be combined");
+      return;
+    }
+    if (!render_distributed(exe_path, path, sloader, n_workers)) return;
+    cout << "writing into " << fname << endl;
+    output.begin(sloader.get_camera()->m_film);
+    output.finish();
+    return;
+  }
+  if (sample_parts > 1) {
+    integrator->render(*scene);
+    string part_name = fname + string_format(".part%d.trfilm", sample_part);
+    cout << "writing part into " << part_name << endl;
+    sloader.get_camera()->m_film->write_partial(part_name, sample_part,
+                                                sample_parts);
+    return;
+  }
+  output.begin(sloader.get_camera()->m_film);
   integrator->render(*scene);
-  auto resolution = sloader.get_resulotion();
 
-  string fname = sloader.get_camera()->m_film->m_filename;
-  sloader.get_camera()->m_film->write_image(1.0, image);
   cout << "writing into " << fname << endl;
-  stbi_write_jpg(fname.c_str(), resolution.x, resolution.y, 3, image, 95);
+  output.finish();
+
+  // Debug image of the pixels with invalid radiance, if any.
+  std::vector<uint8_t> mask;
+  Point2i mask_res;
+  if (integrator->validator() &&
+      integrator->validator()->bad_pixel_mask(&mask, &mask_res)) {
+    string mask_name = fname + ".bad_pixels.png";
+    cout << "writing bad pixel mask into " << mask_name << endl;
+    stbi_write_png(mask_name.c_str(), mask_res.x, mask_res.y, 3, mask.data(),
+                   mask_res.x * 3);
+  }
 }
\ No newline at end of file
@@ -13,6 +13,7 @@
 #include "core/Scene.h"
 #include "core/TRay.h"
 #include "core/imageio.h"
+#include "core/imageoutput.h"
 #include "file_dialog/file_dialog.h"
 #include "gui/Shader.h"
 #include "gui/utility.h"
@@ -21,9 +22,9 @@
 using namespace TRay;
 using namespace std;
 
-uint8_t image[1000 * 1000 * 3];
 const int window_w = 900, window_h = 800;
 int image_w = 200, image_h = 200;
+std::vector<uint8_t> image(image_w * image_h * 3);
 
 double last_render_time = 0;
 double time_cost = 0;
@@ -40,8 +41,11 @@ static bool open_scene_file(const char *path) {
   file_path = path;
   bool stat = sloader.reload(path);
   if (stat) {
-    image_w = sloader.get_resulotion().x;
-    image_h = sloader.get_resulotion().y;
+    Vector2i size =
+        sloader.get_camera()->m_film->m_cropped_pixel_bound.diagonal();
+    image_w = size.x;
+    image_h = size.y;
+    image.assign(size_t(image_w) * image_h * 3, 0);
     return true;
   } else {
     SError("Error loading scene file.");
@@ -51,13 +55,14 @@ static bool open_scene_file(const char *path) {
 static void save_image() {
   if (sloader.get_camera()) {
     string name = sloader.get_camera()->m_film->m_filename;
-    stbi_write_jpg(name.c_str(), image_w, image_h, 3, image, 95);
+    if (is_float_image(name))
+      sloader.get_camera()->m_film->write_pfm(name);
+    else
+      stbi_write_jpg(name.c_str(), image_w, image_h, 3, image.data(), 95);
   }
 }
 
 int main(int argc, char *argv[]) {
-  fill(image, image + sizeof(image), 0);
-
   if (argc > 1) {
     for (int i = 1; i < argc; i++) {
       time_t st = time(NULL);
@@ -188,9 +193,9 @@ int main(int argc, char *argv[]) {
           sloader.get_integrator()->render_step(*(sloader.get_scene()));
       time_cost += glfwGetTime() - time;
       rendering = !done_rendering;
-      sloader.get_camera()->m_film->write_image(1.0, image);
+      sloader.get_camera()->m_film->write_image(1.0, image.data());
       glDeleteTextures(1, &texture0);
-      texture0 = create_texture(image, image_w, image_h);
+      texture0 = create_texture(image.data(), image_w, image_h);
       last_render_time = time;
     }
     // Logo
@@ -324,10 +329,16 @@ void render_file(const char *path) {
   auto scene = sloader.get_scene();
   auto integrator = sloader.get_integrator();
   integrator->render(*scene);
-  auto resolution = sloader.get_resulotion();
+  Film *film = sloader.get_camera()->m_film.get();
 
-  string fname = sloader.get_camera()->m_film->m_filename;
-  sloader.get_camera()->m_film->write_image(1.0, image);
+  string fname = film->m_filename;
   cout << "writing into " << fname << endl;
-  stbi_write_jpg(fname.c_str(), resolution.x, resolution.y, 3, image, 95);
+  if (is_float_image(fname)) {
+    film->write_pfm(fname);
+  } else {
+    Vector2i size = film->m_cropped_pixel_bound.diagonal();
+    image.resize(size_t(size.x) * size.y * 3);
+    film->write_image(1.0, image.data());
+    stbi_write_jpg(fname.c_str(), size.x, size.y, 3, image.data(), 95);
+  }
 }
\ No newline at end of file
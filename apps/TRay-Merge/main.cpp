@@ -0,0 +1,59 @@
+#include <iostream>
+
+#include "core/Film.h"
+#include "core/TRay.h"
+#include "core/imageio.h"
+#include "core/imageoutput.h"
+#include "core/statistics.h"
+#include "filters/filters.h"
+
+using namespace TRay;
+using namespace std;
+
+/**
+ * Usage: TRay-Merge <output image> <partial films...>
+ *
+ * Sums the pixels of the partial films written by TRay-CLI --part k/n for
+ * all k. The parts take disjoint samples, so the merged image is a render
+ * with the samples of all of them.
+ */
+int main(int argc, char *argv[]) {
+  if (argc < 3) {
+    cout << "Usage: TRay-Merge <output image> <partial films...>" << endl;
+    return 1;
+  }
+  PartialFilmHeader header;
+  if (!Film::read_partial_header(argv[2], &header)) return 1;
+  Point2i resolution(header.resolution[0], header.resolution[1]);
+  Bound2f crop_window(Point2f(header.crop_window[0], header.crop_window[1]),
+                      Point2f(header.crop_window[2], header.crop_window[3]));
+  // The filter is only applied when rendering, the sums already hold it.
+  auto film = make_shared<Film>(
+      resolution, crop_window, make_unique<BoxFilter>(Vector2f(0.5, 0.5)),
+      argv[1]);
+  int n_parts = header.n_parts;
+  vector<int> part_count(n_parts, 0);
+  for (int i = 2; i < argc; i++) {
+    if (!film->add_partial(argv[i], &header)) return 1;
+    if (header.n_parts != n_parts || header.part < 0 ||
+        header.part >= n_parts) {
+      SError(string_format("Part %d/%d of %s does not belong to %d parts",
+                           header.part, header.n_parts, argv[i], n_parts));
+      return 1;
+    }
+    part_count[header.part]++;
+  }
+  for (int k = 0; k < n_parts; k++) {
+    if (part_count[k] == 0)
+      SWarn(string_format("Part %d/%d is missing", k, n_parts));
+    else if (part_count[k] > 1)
+      SWarn(string_format("Part %d/%d merged %d times", k, n_parts,
+                          part_count[k]));
+  }
+  cout << "writing into " << film->m_filename << endl;
+  ImageOutput output;
+  output.begin(film);
+  output.finish();
+  output.wait();
+  return 0;
+}
@@ -0,0 +1,31 @@
+/**
+ * @file check.h
+ * @brief Assertions of the checks under apps/test, which keep going after a
+ *        failure and report the count at the end.
+ */
+#pragma once
+#include <iostream>
+
+namespace TRay {
+inline int n_check_failures = 0;
+
+inline bool check(bool ok, const char *expr, const char *file, int line) {
+  if (!ok) {
+    n_check_failures++;
+    std::cerr << file << ":" << line << ": check failed: " << expr
+              << std::endl;
+  }
+  return ok;
+}
+/// @brief Exit code of a check, after printing the failure count.
+inline int check_result(const char *name) {
+  if (n_check_failures)
+    std::cerr << name << ": " << n_check_failures << " failed" << std::endl;
+  else
+    std::cout << name << ": passed" << std::endl;
+  return n_check_failures ? 1 : 0;
+}
+}  // namespace TRay
+
+/// @brief Record a failure of @param x and evaluate to it.
+#define CHECK(x) ::TRay::check(bool(x), #x, __FILE__, __LINE__)
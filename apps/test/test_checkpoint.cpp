@@ -0,0 +1,127 @@
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "check.h"
+#include "core/Integrator.h"
+#include "core/checkpoint.h"
+#include "loaders/KeyVal.h"
+#include "loaders/SceneLoader.h"
+
+using namespace TRay;
+using namespace std;
+using json = nlohmann::json;
+namespace fs = std::filesystem;
+
+/**
+ * Usage: test_checkpoint <scene file>
+ *
+ * A render killed after a checkpoint and run again gives the film of an
+ * uninterrupted render bit for bit. The killed render runs in a child
+ * process, this executable with --render.
+ */
+namespace {
+const char *kScene = "test_checkpoint.json";
+const char *kFilm = "test_checkpoint.pfm";
+const string kCheckpoint = string(kFilm) + ".ckpt";
+
+/// @brief A small copy of @param scene_path, checkpointed after every tile.
+void write_scene(const char *scene_path) {
+  json scene = json::parse(ifstream(scene_path));
+  // Mesh paths are relative to the directory above the scene files.
+  fs::path base = fs::absolute(scene_path).parent_path().parent_path();
+  for (json &shape : scene[Key::Shapes])
+    if (shape.contains(Key::File))
+      shape[Key::File] = (base / shape[Key::File].get<string>()).string();
+  json &film = scene[Key::Camera][Key::Film];
+  film[Key::Name] = kFilm;
+  film[Key::Resolution] = {48, 48};
+  film[Key::Checkpoint] = 0;
+  scene[Key::Sampler][Key::SamplePerPixel] = 4;
+  ofstream(kScene, ios::binary) << scene.dump(2);
+}
+
+/// @brief Render the scene, the film pixels if @param pixels is set.
+bool render(vector<Pixel> *pixels) {
+  SceneLoader loader;
+  if (!loader.load(kScene)) return false;
+  loader.get_integrator()->render(*loader.get_scene());
+  if (pixels) {
+    const Film &film = *loader.get_camera()->m_film;
+    pixels->assign(film.pixels(),
+                   film.pixels() + film.m_cropped_pixel_bound.area());
+  }
+  return true;
+}
+
+/// @brief Start a render in a child process and kill it once it wrote a
+///        checkpoint.
+/// @return false if it finished first.
+bool interrupted_render(const char *self) {
+  pid_t child = fork();
+  if (child == 0) {
+    execl(self, self, "--render", nullptr);
+    _exit(2);
+  }
+  if (!CHECK(child > 0)) return false;
+  bool killed = false;
+  int status;
+  while (waitpid(child, &status, WNOHANG) == 0) {
+    if (fs::exists(kCheckpoint)) {
+      kill(child, SIGKILL);
+      killed = true;
+      waitpid(child, &status, 0);
+      break;
+    }
+    this_thread::sleep_for(chrono::milliseconds(1));
+  }
+  return killed;
+}
+
+/// @brief Tiles marked done in the checkpoint file, -1 if unreadable.
+int tiles_done(uint32_t *n_tiles) {
+  ifstream in(kCheckpoint, ios::binary);
+  FilmCheckpointHeader header;
+  if (!in.read(reinterpret_cast<char *>(&header), sizeof(header))) return -1;
+  vector<char> done(header.n_tiles);
+  if (!in.read(done.data(), header.n_tiles)) return -1;
+  *n_tiles = header.n_tiles;
+  return int(count(done.begin(), done.end(), 1));
+}
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  if (argc > 1 && strcmp(argv[1], "--render") == 0)
+    return render(nullptr) ? 0 : 1;
+  if (!CHECK(argc > 1)) return check_result("checkpoint");
+  write_scene(argv[1]);
+  remove(kCheckpoint.c_str());
+  vector<Pixel> expected, resumed;
+  CHECK(render(&expected));
+  // A finished render leaves no checkpoint.
+  CHECK(!fs::exists(kCheckpoint));
+
+  if (CHECK(interrupted_render(argv[0]))) {
+    uint32_t n_tiles = 0;
+    int n_done = tiles_done(&n_tiles);
+    CHECK(n_done > 0 && uint32_t(n_done) < n_tiles);
+    CHECK(render(&resumed));
+    CHECK(!fs::exists(kCheckpoint));
+    CHECK(resumed.size() == expected.size() &&
+          memcmp(resumed.data(), expected.data(),
+                 expected.size() * sizeof(Pixel)) == 0);
+  }
+  remove(kCheckpoint.c_str());
+  remove(kScene);
+  return check_result("checkpoint");
+}
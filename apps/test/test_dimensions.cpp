@@ -0,0 +1,108 @@
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "check.h"
+#include "core/statistics.h"
+#include "samplers/StratifiedSampler.h"
+#include "samplers/ZeroTwoSampler.h"
+
+using namespace TRay;
+using namespace std;
+
+/**
+ * A PixelSampler made for fewer dimensions than a path uses adds the others,
+ * with the values of its own kind, and counts each added dimension once in
+ * Sampler/dimensions_extended.
+ */
+namespace {
+const int kSpp = 16;
+// Dimensions of each kind drawn by every sample, the sampler is made for 1.
+const int kDims = 4;
+
+/// @brief Sampler/dimensions_extended since the last call.
+int64_t take_extended() {
+  ClearStats();
+  ReportThreadStats();
+  ostringstream os;
+  PrintStats(os);
+  string stats = os.str();
+  size_t at = stats.find("dimensions_extended");
+  if (at == string::npos) return -1;
+  at = stats.find(':', at);
+  return at == string::npos ? -1 : stoll(stats.substr(at + 1));
+}
+
+/// @brief Values of all samples at @param p, by dimension.
+struct PixelValues {
+  vector<vector<Float>> values_1D;
+  vector<vector<Point2f>> values_2D;
+};
+PixelValues draw_pixel(Sampler &sampler, const Point2i &p) {
+  PixelValues pixel;
+  pixel.values_1D.resize(kDims);
+  pixel.values_2D.resize(kDims);
+  sampler.start_pixel(p);
+  do {
+    for (int d = 0; d < kDims; d++) {
+      pixel.values_1D[d].push_back(sampler.sample_1D());
+      pixel.values_2D[d].push_back(sampler.sample_2D());
+    }
+  } while (sampler.next_sample());
+  return pixel;
+}
+
+/// @brief Whether each of @param n strata of [0, 1) holds one value.
+bool stratified(const vector<Float> &values, int n) {
+  vector<int> count(n, 0);
+  for (Float u : values) {
+    if (!(0 <= u && u < 1)) return false;
+    count[int(u * n)]++;
+  }
+  for (int c : count)
+    if (c != 1) return false;
+  return true;
+}
+/// @brief Whether each of the @param nx x @param ny cells of [0, 1)^2 holds
+///        one value.
+bool stratified(const vector<Point2f> &values, int nx, int ny) {
+  vector<int> count(nx * ny, 0);
+  for (const Point2f &u : values) {
+    if (!(0 <= u.x && u.x < 1 && 0 <= u.y && u.y < 1)) return false;
+    count[int(u.y * ny) * nx + int(u.x * nx)]++;
+  }
+  for (int c : count)
+    if (c != 1) return false;
+  return true;
+}
+
+/// @param cells Cell counts in x that the 2D values fill one each, kSpp
+///        cells in total.
+void check_sampler(PixelSampler &sampler, const vector<int> &cells) {
+  take_extended();
+  PixelValues pixel = draw_pixel(sampler, Point2i(0, 0));
+  // Dimensions 1 .. kDims - 1 of each kind, added in the first sample.
+  CHECK(take_extended() == 2 * (kDims - 1));
+  for (int d = 1; d < kDims; d++) {
+    CHECK(pixel.values_1D[d].size() == size_t(kSpp));
+    CHECK(stratified(pixel.values_1D[d], kSpp));
+    for (int nx : cells)
+      CHECK(stratified(pixel.values_2D[d], nx, kSpp / nx));
+  }
+  // The tables stay extended for later pixels and clones.
+  draw_pixel(sampler, Point2i(1, 0));
+  CHECK(take_extended() == 0);
+  unique_ptr<Sampler> clone = sampler.clone(1);
+  draw_pixel(*clone, Point2i(0, 1));
+  CHECK(take_extended() == 0);
+}
+}  // namespace
+
+int main() {
+  ZeroTwoSampler zero_two(kSpp, 1);
+  // A (0, 2)-sequence fills every elementary interval.
+  check_sampler(zero_two, {1, 2, 4, 8, 16});
+  StratifiedSampler stratified_sampler(4, 4, 1, true);
+  check_sampler(stratified_sampler, {4});
+  return check_result("dimensions");
+}
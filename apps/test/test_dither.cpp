@@ -0,0 +1,112 @@
+#include <cmath>
+#include <memory>
+#include <numeric>
+#include <vector>
+
+#include "check.h"
+#include "core/math/RNG.h"
+#include "core/math/bluenoise.h"
+#include "samplers/RandomSampler.h"
+
+using namespace TRay;
+using namespace std;
+
+/**
+ * Dithered, the pixels of a PixelSampler draw the same values shifted modulo
+ * 1 by the mask at the pixel, and the point on film is left as it is.
+ */
+namespace {
+const int kSize = 4, kChannels = 2;
+const int kSpp = 4;
+// Dimensions drawn after the camera sample.
+const int kExtra1D = 3, kExtra2D = 3;
+
+shared_ptr<const BlueNoiseMask> make_mask() {
+  // Any permutation of the ranks of each channel.
+  vector<uint16_t> ranks(kChannels * kSize * kSize);
+  RNG rng(7);
+  for (int c = 0; c < kChannels; c++) {
+    uint16_t *tile = ranks.data() + c * kSize * kSize;
+    iota(tile, tile + kSize * kSize, 0);
+    for (int i = kSize * kSize - 1; i > 0; i--)
+      swap(tile[i], tile[rng.uniform_uint32(i + 1)]);
+  }
+  return make_shared<const BlueNoiseMask>(kSize, kChannels, ranks);
+}
+
+/// @brief Values of one sample with the mask dimension each one is shifted
+///        by, -1 for those left as they are.
+struct Value {
+  Float u;
+  int mask_dim;
+};
+vector<Value> draw(Sampler &sampler, const Point2i &p) {
+  vector<Value> values;
+  CameraSample cs = sampler.camera_sample(p);
+  // 1D and 2D dimensions take apart mask dimensions, see PixelSampler.
+  values.push_back({cs.m_point_film.x - p.x, -1});
+  values.push_back({cs.m_point_film.y - p.y, -1});
+  values.push_back({cs.m_time, 0});
+  values.push_back({cs.m_point_lens.x, 3 * 1 + 1});
+  values.push_back({cs.m_point_lens.y, 3 * 1 + 2});
+  for (int d = 1; d <= kExtra1D; d++)
+    values.push_back({sampler.sample_1D(), 3 * d});
+  for (int d = 2; d <= kExtra2D + 1; d++) {
+    Point2f u = sampler.sample_2D();
+    values.push_back({u.x, 3 * d + 1});
+    values.push_back({u.y, 3 * d + 2});
+  }
+  return values;
+}
+/// @brief Values of all samples at @param p.
+vector<vector<Value>> draw_pixel(Sampler &sampler, const Point2i &p) {
+  vector<vector<Value>> samples;
+  sampler.start_pixel(p);
+  do {
+    samples.push_back(draw(sampler, p));
+  } while (sampler.next_sample());
+  return samples;
+}
+/// @brief @param u shifted back by @param v modulo 1.
+Float unshift(Float u, Float v) {
+  u -= v;
+  return u < 0 ? u + 1 : u;
+}
+/// @brief Distance of @param a and @param b on the unit circle.
+Float circle_distance(Float a, Float b) {
+  Float d = std::abs(a - b);
+  return std::min(d, 1 - d);
+}
+}  // namespace
+
+int main() {
+  shared_ptr<const BlueNoiseMask> mask = make_mask();
+  // Starts with fewer dimensions than drawn, the added ones are dithered
+  // as well.
+  RandomSampler sampler(kSpp, 2);
+  sampler.set_blue_noise(mask);
+  const Point2i p(0, 0), q(1, 2);
+  vector<vector<Value>> at_p = draw_pixel(sampler, p);
+  vector<vector<Value>> at_q = draw_pixel(sampler, q);
+  CHECK(at_p.size() == size_t(kSpp) && at_q.size() == size_t(kSpp));
+  int n_shifted = 0;
+  for (size_t i = 0; i < at_p.size() && i < at_q.size(); i++) {
+    for (size_t k = 0; k < at_p[i].size(); k++) {
+      const Value &a = at_p[i][k], &b = at_q[i][k];
+      if (!CHECK(0 <= a.u && a.u < 1 && 0 <= b.u && b.u < 1)) continue;
+      if (a.mask_dim < 0) {
+        // The point on film is the same in every pixel.
+        CHECK(a.u == b.u);
+        continue;
+      }
+      Float va = mask->value(p, a.mask_dim), vb = mask->value(q, a.mask_dim);
+      n_shifted += va != vb;
+      CHECK(circle_distance(unshift(a.u, va), unshift(b.u, vb)) < 1e-9);
+    }
+  }
+  // The two pixels have different mask values, else nothing was checked.
+  CHECK(n_shifted > 0);
+  CHECK(mask->value(p, 1) != mask->value(q, 1) ||
+        mask->value(p, 2) != mask->value(q, 2));
+  return check_result("dither");
+}
@@ -0,0 +1,116 @@
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "check.h"
+#include "loaders/meshcache.h"
+#include "loaders/meshloading.h"
+#include "shapes/TriangleMesh.h"
+
+using namespace TRay;
+using namespace std;
+
+/**
+ * Usage: test_meshcache <OBJ file with normals>
+ *
+ * Meshes written to a mesh cache read back the same, the cache is refused
+ * for another order, a changed source or indices outside of a shape, and
+ * the meshes loaded from the cache are those parsed.
+ */
+namespace {
+bool same(const MeshData &a, const MeshData &b) {
+  return a.vertices == b.vertices && a.normals == b.normals &&
+         a.uvs == b.uvs && a.indices == b.indices;
+}
+bool same(const vector<MeshData> &a, const vector<MeshData> &b) {
+  if (a.size() != b.size()) return false;
+  for (size_t i = 0; i < a.size(); i++)
+    if (!same(a[i], b[i])) return false;
+  return true;
+}
+/// @brief The meshes of @param cache, copied.
+vector<MeshData> read(const MeshCache &cache) {
+  vector<MeshData> meshes(cache.n_shapes());
+  for (int si = 0; si < cache.n_shapes(); si++) {
+    const MeshCacheShape &shape = cache.shape(si);
+    MeshData &mesh = meshes[si];
+    mesh.vertices.assign(cache.vertices(si),
+                         cache.vertices(si) + shape.n_vertices);
+    if (cache.normals(si))
+      mesh.normals.assign(cache.normals(si),
+                          cache.normals(si) + shape.n_vertices);
+    if (cache.uvs(si))
+      mesh.uvs.assign(cache.uvs(si), cache.uvs(si) + shape.n_vertices);
+    mesh.indices.assign(cache.indices(si),
+                        cache.indices(si) + 3 * shape.n_triangles);
+  }
+  return meshes;
+}
+void copy_file(const char *from, const char *to) {
+  ofstream(to, ios::binary) << ifstream(from, ios::binary).rdbuf();
+}
+
+void check_round_trip() {
+  const char *source = "test_meshcache_source.obj";
+  ofstream(source, ios::binary) << "# stands in for an OBJ file\n";
+  // One shape with every attribute, one with positions only.
+  vector<MeshData> meshes(2);
+  meshes[0].vertices = {{0, 0, 0}, {1, 0, 0}, {0, 1, 0}, {1, 1, 0.5}};
+  meshes[0].normals = {{0, 0, 1}, {0, 0, 1}, {0, 0, 1}, {0, 0.6, 0.8}};
+  meshes[0].uvs = {{0, 0}, {1, 0}, {0, 1}, {1, 1}};
+  meshes[0].indices = {0, 1, 2, 2, 1, 3};
+  meshes[1].vertices = {{-1, -2, -3}, {4, 5, 6}, {7, 8, 0.125}};
+  meshes[1].indices = {0, 1, 2};
+  CHECK(MeshCache::write(source, MeshOrder::Morton, meshes));
+  {
+    MeshCache cache;
+    if (CHECK(cache.open(source, MeshOrder::Morton)))
+      CHECK(same(read(cache), meshes));
+    CHECK(!MeshCache().open(source, MeshOrder::None));
+  }
+  // Indices are kept in the vertices of their shape.
+  for (int bad : {4, -1}) {
+    vector<MeshData> broken = meshes;
+    broken[0].indices[4] = bad;
+    CHECK(MeshCache::write(source, MeshOrder::Morton, broken));
+    CHECK(!MeshCache().open(source, MeshOrder::Morton));
+  }
+  CHECK(MeshCache::write(source, MeshOrder::Morton, meshes));
+  ofstream(source, ios::binary | ios::app) << "v 0 0 0\n";
+  CHECK(!MeshCache().open(source, MeshOrder::Morton));
+  remove(MeshCache::cache_path(source).c_str());
+  remove(source);
+}
+
+void check_load(const char *obj_file) {
+  // Work on a copy, the cache is written next to it.
+  const char *source = "test_meshcache_load.obj";
+  copy_file(obj_file, source);
+  remove(MeshCache::cache_path(source).c_str());
+  vector<MeshData> parsed, cached;
+  CHECK(load_mesh_data(source, MeshOrder::VertexCache, false, &parsed));
+  CHECK(!MeshCache().open(source, MeshOrder::VertexCache));
+  CHECK(load_mesh_data(source, MeshOrder::VertexCache, true, &cached));
+  CHECK(same(parsed, cached));
+  CHECK(MeshCache().open(source, MeshOrder::VertexCache));
+  cached.clear();
+  CHECK(load_mesh_data(source, MeshOrder::VertexCache, true, &cached));
+  CHECK(same(parsed, cached));
+  CHECK(!parsed.empty() && !parsed[0].normals.empty());
+  // Triangles straight from the mapped cache.
+  size_t n_triangles = 0;
+  for (const MeshData &mesh : parsed) n_triangles += mesh.n_triangles();
+  vector<shared_ptr<Shape>> triangles;
+  CHECK(load_triangle_mesh(Transform(), false, &triangles, source, "",
+                           MeshOrder::VertexCache, true));
+  CHECK(triangles.size() == n_triangles);
+  remove(MeshCache::cache_path(source).c_str());
+  remove(source);
+}
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  check_round_trip();
+  if (argc > 1) check_load(argv[1]);
+  return check_result("meshcache");
+}
@@ -0,0 +1,130 @@
+#include <fstream>
+#include <string>
+#include <vector>
+
+#define TINYOBJLOADER_IMPLEMENTATION
+#include "tiny_obj_loader.h"
+
+#include "check.h"
+#include "loaders/objparser.h"
+
+using namespace TRay;
+using namespace std;
+
+/**
+ * Usage: test_objparser [OBJ files...]
+ *
+ * parse_obj gives what tinyobj gives with triangulation, for a small file
+ * covering the record forms and for each argument, on one and on several
+ * threads.
+ */
+namespace {
+// Quads of either diagonal, relative indices, every corner form, and faces
+// before any group.
+const char *kSample =
+    "# sample\n"
+    "v 0 0 0\n"
+    "v 1 0 0\n"
+    "v 1 1 0\n"
+    "v 0 1 0\r\n"
+    "v 0 0 1 \n"
+    "v 3 0 1\n"
+    "v +3 1 1\n"
+    "v 0 1.5e0 1\n"
+    "vn 0 0 1\n"
+    "vn 0 1 0\n"
+    "vt 0 0\n"
+    "vt 1 0\n"
+    "vt 1 1\n"
+    "f 1 2 3\n"
+    "g first\n"
+    "f 1/1 2/2 3/3 4/1\n"
+    "f  5//1 6//1 7//2 8//2\n"
+    "o second\n"
+    "f -4/-3/-2 -3/-2/-2 -2/-1/-1\n"
+    "g\n"
+    "g empty\n"
+    "g last\n"
+    "f 5 6 7 8\n";
+
+void compare(const char *filename, const ObjData &obj) {
+  tinyobj::attrib_t attrib;
+  vector<tinyobj::shape_t> shapes;
+  vector<tinyobj::material_t> materials;
+  string warn, err;
+  if (!CHECK(tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err,
+                              filename, nullptr, true)))
+    return;
+  CHECK(3 * obj.vertices.size() == attrib.vertices.size());
+  CHECK(3 * obj.normals.size() == attrib.normals.size());
+  CHECK(2 * obj.uvs.size() == attrib.texcoords.size());
+  for (size_t i = 0; i < obj.vertices.size(); i++)
+    if (!CHECK(obj.vertices[i] == Point3f(attrib.vertices[3 * i],
+                                          attrib.vertices[3 * i + 1],
+                                          attrib.vertices[3 * i + 2])))
+      break;
+  for (size_t i = 0; i < obj.normals.size(); i++)
+    if (!CHECK(obj.normals[i] == Normal3f(attrib.normals[3 * i],
+                                          attrib.normals[3 * i + 1],
+                                          attrib.normals[3 * i + 2])))
+      break;
+  for (size_t i = 0; i < obj.uvs.size(); i++)
+    if (!CHECK(obj.uvs[i] == Point2f(attrib.texcoords[2 * i],
+                                     attrib.texcoords[2 * i + 1])))
+      break;
+  // tinyobj keeps its shapes without faces, parse_obj drops them.
+  vector<const tinyobj::shape_t *> tiny_shapes;
+  for (const tinyobj::shape_t &shape : shapes)
+    if (!shape.mesh.indices.empty()) tiny_shapes.push_back(&shape);
+  if (!CHECK(obj.shapes.size() == tiny_shapes.size())) return;
+  for (size_t si = 0; si < obj.shapes.size(); si++) {
+    const ObjShape &shape = obj.shapes[si];
+    const vector<tinyobj::index_t> &indices = tiny_shapes[si]->mesh.indices;
+    CHECK(shape.name == tiny_shapes[si]->name);
+    if (!CHECK(3 * shape.n_triangles == indices.size())) continue;
+    for (size_t k = 0; k < indices.size(); k++) {
+      size_t corner = 3 * shape.first_triangle + k;
+      int vn = obj.normal_indices.empty() ? -1 : obj.normal_indices[corner];
+      int vt = obj.uv_indices.empty() ? -1 : obj.uv_indices[corner];
+      if (!CHECK(obj.vertex_indices[corner] == indices[k].vertex_index &&
+                 vn == indices[k].normal_index &&
+                 vt == indices[k].texcoord_index))
+        break;
+    }
+  }
+}
+
+bool same(const ObjData &a, const ObjData &b) {
+  if (a.shapes.size() != b.shapes.size()) return false;
+  for (size_t si = 0; si < a.shapes.size(); si++)
+    if (a.shapes[si].name != b.shapes[si].name ||
+        a.shapes[si].first_triangle != b.shapes[si].first_triangle ||
+        a.shapes[si].n_triangles != b.shapes[si].n_triangles)
+      return false;
+  return a.vertices == b.vertices && a.normals == b.normals &&
+         a.uvs == b.uvs && a.vertex_indices == b.vertex_indices &&
+         a.normal_indices == b.normal_indices && a.uv_indices == b.uv_indices;
+}
+
+void check_file(const char *filename) {
+  cout << filename << endl;
+  ObjData obj;
+  string error;
+  if (!CHECK(parse_obj(filename, &obj, &error, 1))) {
+    cerr << error << endl;
+    return;
+  }
+  compare(filename, obj);
+  ObjData chunked;
+  CHECK(parse_obj(filename, &chunked, &error, 4) && same(obj, chunked));
+}
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  const char *sample = "test_objparser_sample.obj";
+  ofstream(sample, ios::binary) << kSample;
+  check_file(sample);
+  remove(sample);
+  for (int i = 1; i < argc; i++) check_file(argv[i]);
+  return check_result("objparser");
+}
@@ -0,0 +1,89 @@
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "check.h"
+#include "core/parallel.h"
+#include "loaders/meshcache.h"
+#include "loaders/meshloading.h"
+
+using namespace TRay;
+using namespace std;
+
+/**
+ * Usage: test_parallelload <OBJ files...>
+ *
+ * Each file loaded twice at once over 4 threads, writing its cache from
+ * both jobs, gives the meshes of a serial load. Nested parallel_for loops
+ * stay on the calling thread.
+ */
+namespace {
+bool same(const vector<MeshData> &a, const vector<MeshData> &b) {
+  if (a.size() != b.size()) return false;
+  for (size_t i = 0; i < a.size(); i++)
+    if (a[i].vertices != b[i].vertices || a[i].normals != b[i].normals ||
+        a[i].uvs != b[i].uvs || a[i].indices != b[i].indices)
+      return false;
+  return true;
+}
+
+void check_nested() {
+  vector<int> outer_ok(8, 0);
+  parallel_for(
+      8,
+      [&](int64_t i) {
+        thread::id self = this_thread::get_id();
+        bool ok = in_parallel_for;
+        parallel_for(
+            16, [&](int64_t) { ok = ok && this_thread::get_id() == self; },
+            4);
+        outer_ok[i] = ok && in_parallel_for;
+      },
+      4);
+  for (int ok : outer_ok) CHECK(ok);
+  CHECK(!in_parallel_for);
+}
+
+void check_loads(const vector<string> &files) {
+  // Copies, the caches are written next to them.
+  vector<string> sources;
+  vector<vector<MeshData>> serial(files.size());
+  for (size_t i = 0; i < files.size(); i++) {
+    sources.push_back("test_parallelload_" + to_string(i) + ".obj");
+    ofstream(sources[i], ios::binary)
+        << ifstream(files[i], ios::binary).rdbuf();
+    remove(MeshCache::cache_path(sources[i]).c_str());
+    CHECK(load_mesh_data(sources[i].c_str(), MeshOrder::Morton, false,
+                         &serial[i]));
+  }
+  size_t n_jobs = 2 * files.size();
+  vector<vector<MeshData>> loaded(n_jobs);
+  vector<int> ok(n_jobs, 0);
+  parallel_for(
+      int64_t(n_jobs),
+      [&](int64_t i) {
+        ok[i] = load_mesh_data(sources[i % files.size()].c_str(),
+                               MeshOrder::Morton, true, &loaded[i]);
+      },
+      4);
+  for (size_t i = 0; i < n_jobs; i++)
+    CHECK(ok[i] && same(loaded[i], serial[i % files.size()]));
+  // Whichever write won, the cache holds the same meshes.
+  for (size_t i = 0; i < files.size(); i++) {
+    vector<MeshData> cached;
+    CHECK(MeshCache().open(sources[i], MeshOrder::Morton));
+    CHECK(load_mesh_data(sources[i].c_str(), MeshOrder::Morton, true,
+                         &cached) &&
+          same(cached, serial[i]));
+    remove(MeshCache::cache_path(sources[i]).c_str());
+    remove(sources[i].c_str());
+  }
+}
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  check_nested();
+  check_loads(vector<string>(argv + 1, argv + argc));
+  return check_result("parallelload");
+}
@@ -0,0 +1,74 @@
+#include <vector>
+
+#include "check.h"
+#include "core/math/RNG.h"
+#include "core/math/lowdiscrepancy.h"
+
+using namespace TRay;
+using namespace std;
+
+/**
+ * Radical inverses through the digit tables, plain and scrambled, equal
+ * those of the loop over one digit at a time.
+ */
+namespace {
+vector<int> primes() {
+  vector<int> result;
+  for (int v = 2; int(result.size()) < NPrimes; v++) {
+    bool is_prime = true;
+    for (int p : result) {
+      if (p * p > v) break;
+      if (v % p == 0) {
+        is_prime = false;
+        break;
+      }
+    }
+    if (is_prime) result.push_back(v);
+  }
+  return result;
+}
+/// @brief One digit at a time, each permuted by @param perm if set.
+Float digit_loop(int base, uint64_t a, const uint16_t *perm) {
+  const Float base_inv = Float(1) / Float(base);
+  Float baseN_inv = 1;
+  uint64_t inverse_digits = 0;
+  while (a) {
+    uint64_t next = a / base;
+    uint64_t digit = a - next * base;
+    inverse_digits = inverse_digits * base + (perm ? perm[digit] : digit);
+    baseN_inv *= base_inv;
+    a = next;
+  }
+  if (!perm) return std::min(inverse_digits * baseN_inv, ONE_M_EPS);
+  // The permuted zeros beyond the last digit.
+  const Float tail = base_inv * perm[0] / (1 - base_inv);
+  return std::min(baseN_inv * (inverse_digits + tail), ONE_M_EPS);
+}
+}  // namespace
+
+int main() {
+  vector<uint64_t> indices;
+  for (uint64_t a = 0; a < 2048; a++) indices.push_back(a);
+  RNG rng(11);
+  for (int bits = 1; bits <= 64; bits++)
+    for (int i = 0; i < 8; i++) {
+      uint64_t a = uint64_t(rng.uniform_uint32()) << 32;
+      a |= rng.uniform_uint32();
+      indices.push_back(a >> (64 - bits));
+    }
+  DigitPermutations perms(rng);
+  vector<int> bases = primes();
+  for (int i = 0; i < NPrimes; i++) {
+    const uint16_t *perm = perms.tables(i);
+    for (uint64_t a : indices) {
+      // Base 2 reverses the bits instead.
+      if (i > 0 &&
+          !CHECK(radical_inverse(i, a) == digit_loop(bases[i], a, nullptr)))
+        break;
+      if (!CHECK(scrambled_radical_inverse(i, a, perms) ==
+                 digit_loop(bases[i], a, perm)))
+        break;
+    }
+  }
+  return check_result("radicalinverse");
+}
@@ -0,0 +1,58 @@
+#include <algorithm>
+#include <numeric>
+#include <vector>
+
+#include "check.h"
+#include "core/math/RNG.h"
+
+using namespace TRay;
+using namespace std;
+
+/**
+ * Bounded draws of RNG stay below their bound and are uniform, shuffles are
+ * permutations.
+ */
+namespace {
+/// @brief @param n draws below @param b, counted in @param n_bins equal
+///        ranges, each within @param tolerance of its share.
+void check_uniform(RNG &rng, uint32_t b, int n_bins, int n,
+                   double tolerance) {
+  vector<int> counts(n_bins, 0);
+  for (int i = 0; i < n; i++) {
+    uint32_t v = rng.uniform_uint32(b);
+    if (!CHECK(v < b)) return;
+    counts[uint64_t(v) * n_bins / b]++;
+  }
+  for (int count : counts)
+    CHECK(std::abs(count - double(n) / n_bins) < tolerance * n / n_bins);
+}
+}  // namespace
+
+int main() {
+  RNG rng(3);
+  // Small bounds, bounds around powers of 2, and the largest one.
+  vector<uint32_t> bounds = {1,          2,          3,          5,
+                             7,          10,         1000,       65537,
+                             0x7fffffff, 0x80000000, 0x80000001, 0xfffffffe,
+                             0xffffffff};
+  for (int i = 0; i < 64; i++) bounds.push_back(1 + rng.uniform_uint32());
+  for (uint32_t b : bounds)
+    for (int i = 0; i < 10000; i++)
+      if (!CHECK(rng.uniform_uint32(b) < b)) break;
+  CHECK(rng.uniform_uint32(1) == 0);
+
+  // Every value of small bounds, and the thirds of 3 * 2^30, where taking
+  // a draw modulo the bound would favor the lower third twice over.
+  check_uniform(rng, 3, 3, 300000, 0.02);
+  check_uniform(rng, 6, 6, 600000, 0.02);
+  check_uniform(rng, 0xc0000000, 3, 300000, 0.02);
+
+  vector<int> values(1000);
+  iota(values.begin(), values.end(), 0);
+  vector<int> shuffled = values;
+  rng.shuffle(shuffled.begin(), shuffled.end());
+  CHECK(shuffled != values);
+  sort(shuffled.begin(), shuffled.end());
+  CHECK(shuffled == values);
+  return check_result("rng");
+}
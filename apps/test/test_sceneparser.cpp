@@ -0,0 +1,103 @@
+#include <fstream>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <vector>
+
+#include "check.h"
+#include "loaders/KeyVal.h"
+#include "loaders/sceneparser.h"
+
+using namespace TRay;
+using namespace std;
+using json = nlohmann::json;
+
+/**
+ * Usage: test_sceneparser <scene files...>
+ *
+ * SceneFileParser gives the DOM of json::parse with the inline mesh arrays
+ * replaced by null, and those arrays in the meshes. The world hash only
+ * follows the world content.
+ */
+namespace {
+const char *kTemp = "test_sceneparser.json";
+
+/// @brief Parse @param scene written to a file, indented by @param indent.
+bool parse(const json &scene, SceneFileParser *parser, json *dom,
+           int indent = -1) {
+  ofstream(kTemp, ios::binary) << scene.dump(indent);
+  string error;
+  return parser->parse(kTemp, dom, &error);
+}
+
+void check_scene(const char *path) {
+  cout << path << endl;
+  json reference = json::parse(ifstream(path));
+  SceneFileParser parser;
+  json dom;
+  string error;
+  if (!CHECK(parser.parse(path, &dom, &error))) {
+    cerr << error << endl;
+    return;
+  }
+  vector<MeshData> meshes;
+  CHECK(parser.read_inline_meshes(&meshes, &error));
+  json expected = reference;
+  json &shapes = reference[Key::Shapes];
+  CHECK(meshes.size() <= shapes.size());
+  for (size_t i = 0; i < shapes.size(); i++) {
+    const json &shape = shapes[i];
+    MeshData mesh = i < meshes.size() ? meshes[i] : MeshData();
+    if (shape.contains(Key::Vertex)) {
+      expected[Key::Shapes][i][Key::Vertex] = nullptr;
+      vector<Point3f> vertices;
+      for (const json &v : shape[Key::Vertex])
+        vertices.emplace_back(v[0].get<Float>(), v[1].get<Float>(),
+                              v[2].get<Float>());
+      CHECK(mesh.vertices == vertices);
+    } else {
+      CHECK(mesh.vertices.empty());
+    }
+    if (shape.contains(Key::Index)) {
+      expected[Key::Shapes][i][Key::Index] = nullptr;
+      CHECK(mesh.indices == shape[Key::Index].get<vector<int>>());
+    } else {
+      CHECK(mesh.indices.empty());
+    }
+  }
+  CHECK(dom == expected);
+
+  // Formatting does not change the hash, the view entries do not either.
+  // Key order does, and dumps sort the keys, so only dumps are compared.
+  CHECK(parse(reference, &parser, &dom));
+  uint64_t hash = parser.world_hash();
+  CHECK(parse(reference, &parser, &dom, 2) && parser.world_hash() == hash);
+  json view = reference;
+  view[Key::Camera] = "elsewhere";
+  view[Key::Snapshot] = true;
+  CHECK(parse(view, &parser, &dom) && parser.world_hash() == hash);
+  json world = reference;
+  world[Key::Shapes][0]["name"] = "renamed";
+  CHECK(parse(world, &parser, &dom) && parser.world_hash() != hash);
+}
+
+void check_errors() {
+  SceneFileParser parser;
+  json dom;
+  string error;
+  ofstream(kTemp, ios::binary)
+      << R"({"shapes": [{"vertex": [[0, 0, 0], [1, 0]]}]})";
+  CHECK(!parser.parse(kTemp, &dom, &error) && !error.empty());
+  ofstream(kTemp, ios::binary) << R"({"shapes": [{"index": [0, "1"]}]})";
+  CHECK(!parser.parse(kTemp, &dom, &error));
+  ofstream(kTemp, ios::binary) << R"({"shapes": [)";
+  CHECK(!parser.parse(kTemp, &dom, &error));
+  CHECK(!parser.parse("test_sceneparser_missing.json", &dom, &error));
+}
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  for (int i = 1; i < argc; i++) check_scene(argv[i]);
+  check_errors();
+  remove(kTemp);
+  return check_result("sceneparser");
+}
@@ -0,0 +1,146 @@
+#include <filesystem>
+#include <fstream>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <vector>
+
+#include "check.h"
+#include "core/Scene.h"
+#include "core/geometry/Interaction.h"
+#include "loaders/KeyVal.h"
+#include "loaders/SceneLoader.h"
+#include "loaders/meshcache.h"
+#include "loaders/scenesnapshot.h"
+
+using namespace TRay;
+using namespace std;
+using json = nlohmann::json;
+namespace fs = std::filesystem;
+
+/**
+ * Usage: test_snapshot <scene file with an OBJ mesh>
+ *
+ * Snapshots read back what was written and are refused for another key.
+ * Through SceneLoader, a second load with another camera takes the meshes
+ * from the snapshot, and touching the OBJ file drops it.
+ */
+namespace {
+const char *kScene = "test_snapshot.json";
+const char *kObj = "test_snapshot.obj";
+
+void check_round_trip() {
+  vector<MeshData> meshes(2);
+  meshes[0].vertices = {{0, 0, 0}, {1, 0, 0}, {0, 1, 0}};
+  meshes[0].normals = {{0, 0, 1}, {0, 0, 1}, {0, 0.6, 0.8}};
+  meshes[0].indices = {0, 1, 2};
+  meshes[1].vertices = {{-1, -2, -3}, {4, 5, 6}, {7, 8, 0.125}, {1, 1, 1}};
+  meshes[1].uvs = {{0, 0}, {1, 0}, {0, 1}, {1, 1}};
+  meshes[1].indices = {0, 1, 2, 2, 1, 3};
+  vector<uint32_t> owners = {3, 1};
+  CHECK(SceneSnapshot::write(kScene, 42, owners, meshes));
+  SceneSnapshot snapshot;
+  if (CHECK(snapshot.open(kScene, 42)) &&
+      CHECK(snapshot.n_shapes() == 2)) {
+    for (int i = 0; i < 2; i++) {
+      const MeshCacheShape &shape = snapshot.shape(i);
+      const MeshData &mesh = meshes[i];
+      CHECK(snapshot.owner(i) == owners[i]);
+      CHECK(shape.n_vertices == mesh.vertices.size() &&
+            shape.n_triangles == mesh.indices.size() / 3);
+      CHECK(equal(mesh.vertices.begin(), mesh.vertices.end(),
+                  snapshot.vertices(i)));
+      CHECK(mesh.normals.empty() ? !snapshot.normals(i)
+                                 : equal(mesh.normals.begin(),
+                                         mesh.normals.end(),
+                                         snapshot.normals(i)));
+      CHECK(mesh.uvs.empty()
+                ? !snapshot.uvs(i)
+                : equal(mesh.uvs.begin(), mesh.uvs.end(), snapshot.uvs(i)));
+      CHECK(equal(mesh.indices.begin(), mesh.indices.end(),
+                  snapshot.indices(i)));
+    }
+  }
+  snapshot.close();
+  CHECK(!snapshot.open(kScene, 43));
+  remove(SceneSnapshot::snapshot_path(kScene).c_str());
+}
+
+/// @brief Hit points of rays from the center of the scene in many
+///        directions, as a fingerprint of its geometry.
+vector<Point3f> hits(const Scene &scene) {
+  vector<Point3f> points;
+  Point3f center = scene.world_bound().lerp(Point3f(0.5, 0.5, 0.5));
+  const int n = 256;
+  for (int i = 0; i < n; i++) {
+    // Fibonacci sphere.
+    Float z = 1 - (2 * i + 1) / Float(n);
+    Float r = std::sqrt(1 - z * z), phi = i * 2.399963229728653;
+    SurfaceInteraction si;
+    Ray ray(center, Vector3f(r * std::cos(phi), r * std::sin(phi), z));
+    points.push_back(scene.intersect(ray, &si) ? si.p : Point3f(0, 0, 0));
+  }
+  return points;
+}
+
+void check_loader(const char *scene_path) {
+  json scene = json::parse(ifstream(scene_path));
+  scene[Key::Snapshot] = true;
+  string source;
+  for (json &shape : scene[Key::Shapes])
+    if (shape[Key::Type].get<string>() == Val::MeshObj) {
+      source = (fs::path(scene_path).parent_path().parent_path() /
+                shape[Key::File].get<string>())
+                   .string();
+      shape[Key::File] = kObj;
+    }
+  if (!CHECK(!source.empty())) return;
+  fs::copy_file(source, kObj, fs::copy_options::overwrite_existing);
+  ofstream(kScene, ios::binary) << scene.dump(2);
+  string snapshot_path = SceneSnapshot::snapshot_path(kScene);
+  remove(snapshot_path.c_str());
+
+  SceneLoader first;
+  if (!CHECK(first.load(kScene))) return;
+  const vector<Point3f> expected = hits(*first.get_scene());
+  CHECK(fs::exists(snapshot_path));
+
+  // Garble the OBJ file in place, keeping its size and time, and drop its
+  // cache. Only the snapshot still has the mesh.
+  auto time = fs::last_write_time(kObj);
+  string text;
+  {
+    ifstream f(kObj, ios::binary);
+    text.assign(istreambuf_iterator<char>(f), istreambuf_iterator<char>());
+  }
+  // Only the positions, the faces stay valid.
+  for (size_t i = 0; i < text.size(); i++)
+    if (text[i] == '1' && text.rfind("\nv ", i) == text.rfind('\n', i))
+      text[i] = '7';
+  ofstream(kObj, ios::binary) << text;
+  fs::last_write_time(kObj, time);
+  remove(MeshCache::cache_path(kObj).c_str());
+
+  scene[Key::Camera][Key::Film][Key::Name] = "test_snapshot_other.png";
+  ofstream(kScene, ios::binary) << scene.dump(2);
+  SceneLoader second;
+  if (CHECK(second.load(kScene)))
+    CHECK(hits(*second.get_scene()) == expected);
+
+  // A newer OBJ file is read again.
+  fs::last_write_time(kObj, time + 1s);
+  SceneLoader third;
+  if (CHECK(third.load(kScene)))
+    CHECK(hits(*third.get_scene()) != expected);
+
+  remove(snapshot_path.c_str());
+  remove(MeshCache::cache_path(kObj).c_str());
+  remove(kObj);
+  remove(kScene);
+}
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  check_round_trip();
+  if (argc > 1) check_loader(argv[1]);
+  return check_result("snapshot");
+}
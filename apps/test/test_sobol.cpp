@@ -0,0 +1,69 @@
+#include <vector>
+
+#include "check.h"
+#include "core/math/RNG.h"
+#include "core/math/lowdiscrepancy.h"
+
+using namespace TRay;
+using namespace std;
+
+/**
+ * Sobol' values through the byte tables, single and batched, equal those of
+ * the loop over the bits of the index.
+ */
+namespace {
+uint32_t bit_loop32(uint64_t a, int dimension) {
+  uint32_t v = 0;
+  for (int i = dimension * SobolMatrixSize; a != 0; a >>= 1, ++i)
+    if (a & 1) v ^= SobolMatrices32[i];
+  return v;
+}
+uint64_t bit_loop64(uint64_t a, int dimension) {
+  uint64_t v = 0;
+  for (int i = dimension * SobolMatrixSize; a != 0; a >>= 1, ++i)
+    if (a & 1) v ^= SobolMatrices64[i];
+  return v;
+}
+
+/// @brief Small indices and random ones of every length up to the
+///        SobolMatrixSize bits the matrices cover.
+vector<int64_t> indices() {
+  vector<int64_t> result;
+  for (int64_t a = 0; a < 1024; a++) result.push_back(a);
+  RNG rng(7);
+  for (int bits = 1; bits <= SobolMatrixSize; bits++)
+    for (int i = 0; i < 64; i++) {
+      uint64_t a = uint64_t(rng.uniform_uint32()) << 32;
+      a |= rng.uniform_uint32();
+      result.push_back(int64_t(a >> (64 - bits)));
+    }
+  return result;
+}
+}  // namespace
+
+int main() {
+  const int n_dimensions = NSobolTableDimensions + 8;
+  const uint32_t scramble = 0x9e3779b9u;
+  vector<Float> batch(n_dimensions);
+  for (int64_t a : indices()) {
+    for (int d = 0; d < n_dimensions; d++) {
+      if (!CHECK(Sobol_bits32(a, d) == bit_loop32(a, d))) break;
+      if (!CHECK(sample_Sobol_float(a, d, scramble) ==
+                 (bit_loop32(a, d) ^ scramble) * 0x1p-32f))
+        break;
+      // sample_Sobol_double returns a float.
+      float expected = float(std::min(
+          (bit_loop64(a, d) ^ scramble) * (1.0 / (1ull << SobolMatrixSize)),
+          ONE_M_EPS));
+      if (!CHECK(sample_Sobol_double(a, d, scramble) == expected)) break;
+    }
+    // Batches starting inside and across the end of the tables.
+    for (int first : {0, 1, NSobolTableDimensions - 3}) {
+      int n = n_dimensions - first;
+      sample_Sobol(a, first, n, batch.data(), scramble);
+      for (int d = 0; d < n; d++)
+        if (!CHECK(batch[d] == sample_Sobol(a, first + d, scramble))) break;
+    }
+  }
+  return check_result("sobol");
+}
@@ -0,0 +1,87 @@
+#include <memory>
+#include <vector>
+
+#include "check.h"
+#include "core/math/RNG.h"
+#include "core/math/lowdiscrepancy.h"
+#include "core/math/sampling.h"
+
+using namespace TRay;
+using namespace std;
+
+/**
+ * ZeroTwoTable and the fills reading it give the values of the Gray code
+ * fills from the generator matrices they replace.
+ */
+namespace {
+// Van der Corput, the identity.
+uint32_t CVanDerCorput[32];
+// The second Sobol' dimension.
+const uint32_t *CSobol1 = SobolMatrices32 + SobolMatrixSize;
+
+void check_table(uint32_t n) {
+  ZeroTwoTable table(n);
+  CHECK(table.size() == n);
+  vector<Float> expected(n);
+  vector<Point2f> expected_2D(n);
+  RNG rng(n);
+  for (int k = 0; k < 4; k++) {
+    uint32_t sx = k ? rng.uniform_uint32() : 0;
+    uint32_t sy = k ? rng.uniform_uint32() : 0;
+    fill_sample_by_graycode(CVanDerCorput, n, sx, expected.data());
+    fill_sample_by_graycode(CVanDerCorput, CSobol1, n,
+                            Point2i(int(sx), int(sy)), expected_2D.data());
+    for (uint32_t i = 0; i < n; i++)
+      if (!CHECK((table.x()[i] ^ sx) * 0x1p-32f == expected[i] &&
+                 std::min((table.x()[i] ^ sx) * Float(0x1p-32), ONE_M_EPS) ==
+                     expected_2D[i].x &&
+                 std::min((table.y()[i] ^ sy) * Float(0x1p-32), ONE_M_EPS) ==
+                     expected_2D[i].y))
+        break;
+  }
+}
+
+/// @brief The fills, against the Gray code fills followed by the same
+///        shuffles.
+void check_fills(const ZeroTwoTable &table, int n_sub, int n_pxl) {
+  int n = n_sub * n_pxl;
+  vector<Float> values(n), expected(n);
+  vector<Point2f> values_2D(n), expected_2D(n);
+  RNG rng(n_sub), reference(n_sub);
+  fill_VDCorput_1D(n_sub, n_pxl, table, values.data(), rng);
+  fill_sample_by_graycode(CVanDerCorput, n, reference.uniform_uint32(),
+                          expected.data());
+  for (int i = 0; i < n_pxl; i++)
+    shuffle(expected.data() + i * n_sub, n_sub, 1, reference);
+  shuffle(expected.data(), n_pxl, n_sub, reference);
+  CHECK(values == expected);
+
+  fill_Sobol_2D(n_sub, n_pxl, table, values_2D.data(), rng);
+  uint32_t sx = reference.uniform_uint32();
+  uint32_t sy = reference.uniform_uint32();
+  fill_sample_by_graycode(CVanDerCorput, CSobol1, n,
+                          Point2i(int(sx), int(sy)), expected_2D.data());
+  for (int i = 0; i < n_pxl; i++)
+    shuffle(expected_2D.data() + i * n_sub, n_sub, 1, reference);
+  shuffle(expected_2D.data(), n_pxl, n_sub, reference);
+  CHECK(values_2D == expected_2D);
+}
+}  // namespace
+
+int main() {
+  for (int i = 0; i < 32; i++) CVanDerCorput[i] = 0x80000000u >> i;
+  for (uint32_t n = 1; n <= 4096; n *= 2) check_table(n);
+
+  // A table serves every smaller power of 2, fit_table only grows it.
+  shared_ptr<const ZeroTwoTable> table;
+  fit_table(table, 100);
+  CHECK(table && table->size() == 128);
+  const ZeroTwoTable *fitted = table.get();
+  fit_table(table, 64);
+  CHECK(table.get() == fitted);
+  fit_table(table, 1024);
+  CHECK(table->size() == 1024);
+  for (auto [n_sub, n_pxl] : {pair{1, 16}, pair{4, 16}, pair{16, 64}})
+    check_fills(*table, n_sub, n_pxl);
+  return check_result("zerotwo");
+}
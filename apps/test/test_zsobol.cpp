@@ -0,0 +1,76 @@
+#include <algorithm>
+#include <vector>
+
+#include "check.h"
+#include "samplers/ZSobolSampler.h"
+
+using namespace TRay;
+using namespace std;
+
+/**
+ * The arrays of a pixel take n * spp local indices of ZSobolSampler, those of
+ * neighbouring pixels must not run into each other.
+ */
+namespace {
+struct PixelArrays {
+  vector<Float> values_1D;
+  vector<Point2f> values_2D;
+};
+
+PixelArrays arrays_of(ZSobolSampler &sampler, const Point2i &p, int n_1D,
+                      int n_2D) {
+  sampler.start_pixel(p);
+  const Float *a = sampler.get_1D_array(n_1D);
+  const Point2f *b = sampler.get_2D_array(n_2D);
+  PixelArrays arrays;
+  arrays.values_1D.assign(a, a + n_1D * sampler.m_spp);
+  arrays.values_2D.assign(b, b + n_2D * sampler.m_spp);
+  return arrays;
+}
+
+template <typename T>
+bool disjoint(vector<T> a, vector<T> b) {
+  auto less = [](const T &l, const T &r) {
+    if constexpr (std::is_same_v<T, Point2f>)
+      return l.x < r.x || (l.x == r.x && l.y < r.y);
+    else
+      return l < r;
+  };
+  sort(a.begin(), a.end(), less);
+  sort(b.begin(), b.end(), less);
+  vector<T> both;
+  set_intersection(a.begin(), a.end(), b.begin(), b.end(),
+                   back_inserter(both), less);
+  return both.empty();
+}
+
+bool in_unit(const PixelArrays &arrays) {
+  for (Float u : arrays.values_1D)
+    if (!(0 <= u && u < 1)) return false;
+  for (const Point2f &u : arrays.values_2D)
+    if (!(0 <= u.x && u.x < 1 && 0 <= u.y && u.y < 1)) return false;
+  return true;
+}
+
+void check_neighbours(int spp, int n_1D, int n_2D) {
+  ZSobolSampler sampler(spp, Bound2i(Point2i(0, 0), Point2i(8, 8)));
+  sampler.request_1D_array(n_1D);
+  sampler.request_2D_array(n_2D);
+  PixelArrays origin = arrays_of(sampler, Point2i(0, 0), n_1D, n_2D);
+  CHECK(in_unit(origin));
+  for (Point2i p : {Point2i(1, 0), Point2i(0, 1), Point2i(1, 1)}) {
+    PixelArrays next = arrays_of(sampler, p, n_1D, n_2D);
+    CHECK(in_unit(next));
+    CHECK(disjoint(origin.values_1D, next.values_1D));
+    CHECK(disjoint(origin.values_2D, next.values_2D));
+  }
+}
+}  // namespace
+
+int main() {
+  check_neighbours(4, 1, 2);
+  check_neighbours(4, 4, 2);
+  check_neighbours(2, 8, 16);
+  check_neighbours(16, 2, 4);
+  return check_result("zsobol");
+}
@@ -1,5 +1,6 @@
 #pragma once
 #include "core/primitives/Aggregate.h"
+#include "core/statistics.h"
 
 namespace TRay {
 class LinearAccel : public Aggregate {
@@ -17,6 +18,7 @@ class LinearAccel : public Aggregate {
  private:
   std::vector<std::shared_ptr<Primitive>> m_primitives;
   Bound3f m_world_bound;
+  TrackedMemory m_memory;
 };
 
 }  // namespace TRay
\ No newline at end of file
@@ -1,9 +1,12 @@
 #pragma once
+#include <functional>
+
 #include "core/TRay.h"
 #include "core/geometry/Point.h"
 #include "core/geometry/Bound.h"
 #include "core/Filter.h"
 #include "core/spectrum/spectrum.h"
+#include "core/statistics.h"
 
 namespace TRay {
 /// @brief Sum of 'weight * value' and sum of weight.
@@ -18,6 +21,20 @@ struct Pixel {
   Float rgb[3] = {0, 0, 0};
   Float filter_weight_sum = 0;
 };
+/**
+ * @brief Header of a partial film, the pixel sums of one of several renders
+ *        of the same image with disjoint samples. Followed by the Pixel
+ *        array of the cropped pixel bound, in native byte order.
+ */
+struct PartialFilmHeader {
+  char magic[4];
+  uint32_t version;
+  uint32_t float_size;
+  int32_t part, n_parts;
+  int32_t resolution[2];
+  // p_min and p_max of the crop window.
+  double crop_window[4];
+};
 
 class Film {
  public:
@@ -31,6 +48,9 @@ class Film {
    */
   Film(const Point2i &resolution, const Bound2f &crop_window,
        std::unique_ptr<Filter> filter, const std::string &filename);
+  /// @brief Store only @param pixel_bound, in raster space, from now on.
+  ///        The pixels are cleared.
+  void recrop(const Bound2i &pixel_bound);
   /// @brief Get the area to be sampled.
   Bound2i sample_bound() const;
   // Bound2f physical_extent() const; // The physical area of film.
@@ -43,9 +63,35 @@ class Film {
   /// @param colors Spectrum array. The size should be equal to image area.
   void set_image(const Spectrum *colors);
   /// @brief Write image as RGBRGBRGB... into dst.
+  ///        dst holds 3 bytes for each pixel of m_cropped_pixel_bound.
   void write_image(Float, uint8_t *dst);
+  /// @brief Write rows [y0, y1) of the image, counted from the top of the
+  ///        cropped pixel bound, into dst laid out as in write_image.
+  void write_image_rows(int y0, int y1, uint8_t *dst) const;
+  /// @brief Called with the image rows [y0, y1) that no later tile will
+  ///        touch, in increasing order.
+  using RowsCallback = std::function<void(int y0, int y1)>;
+  void set_rows_callback(RowsCallback callback);
+  /// @brief All tiles of the sample rows before @param y are merged.
+  ///        Reports the rows out of reach of the remaining samples' filter.
+  void samples_merged_below(int y);
+  /// @brief Pixels of m_cropped_pixel_bound, row by row.
+  Pixel *pixels() { return m_pixels.get(); }
+  const Pixel *pixels() const { return m_pixels.get(); }
+  /// @brief Write the linear radiance, i.e. the weighted sums over the
+  ///        weights, as a PFM file. Rows are converted one at a time.
+  bool write_pfm(const std::string &filename);
+  /// @brief Write the pixel sums as part @param part of @param n_parts.
+  bool write_partial(const std::string &filename, int part,
+                     int n_parts) const;
+  /// @brief Add the pixel sums of a partial film of the same image.
+  /// @param header Set to the header of the file.
+  bool add_partial(const std::string &filename, PartialFilmHeader *header);
+  static bool read_partial_header(const std::string &filename,
+                                  PartialFilmHeader *header);
 
   Point2i m_full_resolution;
+  Bound2f m_crop_window;
   std::unique_ptr<Filter> m_filter;
   const std::string m_filename;
   Bound2i m_cropped_pixel_bound;
@@ -54,6 +100,10 @@ class Film {
   Pixel &pixel(const Point2i &p);
   // Pointer to the pixel array.
   std::unique_ptr<Pixel[]> m_pixels;
+  TrackedMemory m_memory;
+  RowsCallback m_rows_callback;
+  // Rows reported to m_rows_callback.
+  int m_rows_final = 0;
   static constexpr int filter_table_width = 16;
   /// @brief 1/4 part of the filter table, assuming that the other 3 parts are
   /// symmertric. The precision error of position is not significant.
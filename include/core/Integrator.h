@@ -3,6 +3,8 @@
 #include "core/Film.h"
 #include "core/Camera.h"
 #include "core/Sampler.h"
+#include "core/checkpoint.h"
+#include "core/validation.h"
 
 namespace TRay {
 /// @brief Integrator interface.
@@ -11,18 +13,44 @@ class Integrator {
   virtual ~Integrator() {}
   virtual void render(const Scene &scene) = 0;
   virtual bool render_step(const Scene &scene) = 0;
+  /// @brief Bad radiance values met in last rendering, if tracked.
+  virtual const RadianceValidator *validator() const { return nullptr; }
+  /// @brief Checkpoint the film during render, if supported.
+  virtual void set_checkpoint(std::shared_ptr<FilmCheckpoint>) {}
+  /// @brief Render only part @param part of @param n_parts of the samples.
+  ///        Parts take disjoint samples, their films sum to a full render.
+  /// @return false if not supported.
+  virtual bool set_sample_part(int, int) { return false; }
 };
 
 class SamplerIntegrator : public Integrator {
  public:
   SamplerIntegrator(std::shared_ptr<const Camera> &camera,
                     std::shared_ptr<Sampler> &sampler)
-      : m_camera(camera), m_sampler(sampler) {}
+      : m_camera(camera),
+        m_sampler(sampler),
+        m_validator(std::make_unique<RadianceValidator>()) {}
   void render(const Scene &scene) override;
   bool render_step(const Scene &scene) override;
+  const RadianceValidator *validator() const override {
+    return m_validator.get();
+  }
+  void set_checkpoint(std::shared_ptr<FilmCheckpoint> checkpoint) override {
+    m_checkpoint = std::move(checkpoint);
+  }
+  bool set_sample_part(int part, int n_parts) override {
+    m_sample_part = part;
+    m_sample_parts = n_parts;
+    return true;
+  }
   virtual void preprocess(const Scene &, Sampler &) {
     SInfo("SamplerIntegrator::preprocess: Start preprocessing.");
   }
+  /// @brief Dimensions Li() takes from a sample vector at most, camera
+  ///        samples excluded. Paths going deeper still get values.
+  virtual SampleDimensions sample_dimensions(const Scene &) const {
+    return {};
+  }
   /// @brief Evaluate the incident radiance.
   /// @param ray The ray along which the radiance should be evaluated.
   /// @param scene The scene to be rendered.
@@ -42,8 +70,14 @@ class SamplerIntegrator : public Integrator {
 
  protected:
  private:
+  /// @brief preprocess() and size the sampler for the sample vectors.
+  void prepare(const Scene &scene);
+
   std::shared_ptr<const Camera> m_camera;
   std::shared_ptr<Sampler> m_sampler;
+  std::unique_ptr<RadianceValidator> m_validator;
+  std::shared_ptr<FilmCheckpoint> m_checkpoint;
+  int m_sample_part = 0, m_sample_parts = 1;
 
  private:
   struct TileUnit {
@@ -77,25 +111,8 @@ class SamplerIntegrator : public Integrator {
       Spectrum L(0.0);
       if (ray_w > 0) L = integrator.Li(ray, scene, *tile_sampler);
       // Check.
-      if (L.has_NaN()) {
-        SError(string_format(
-            "Get NaN radiance value "
-            "for pixel (%d, %d), sample %d. Black value is used.",
-            pxl.x, pxl.y, (int)tile_sampler->current_sample_index()));
-        L = Spectrum(0.f);
-      } else if (L.y() < -1e-5) {
-        SError(string_format(
-            "Get negative radiance value, %f "
-            "for pixel (%d, %d), sample %d. Black value is used.",
-            L.y(), pxl.x, pxl.y, (int)tile_sampler->current_sample_index()));
-        L = Spectrum(0.f);
-      } else if (std::isinf(L.y())) {
-        SError(string_format(
-            "Get INF radiance value "
-            "for pixel (%d, %d), sample %d. Black value is used.",
-            pxl.x, pxl.y, (int)tile_sampler->current_sample_index()));
-        L = Spectrum(0.f);
-      }
+      integrator.m_validator->validate(&L, pxl,
+                                       tile_sampler->current_sample_index());
       film_tile->add_sample(cam_sample.m_point_film, L, ray_w);
 
       current_samples++;
@@ -11,6 +11,7 @@
 #include <list>
 
 #include "core/TRay.h"
+#include "core/statistics.h"
 
 namespace TRay {
 void *allocAligned(size_t size);
@@ -26,8 +27,7 @@ class
 #endif
         MemoryPool {
  public:
-  MemoryPool(size_t block_size = 262144 /* 256KB */)
-      : kMinBlockSize_(block_size) {}
+  MemoryPool(size_t block_size = 262144 /* 256KB */);
   ~MemoryPool();
   void *alloc(size_t n_bytes);
   /// @brief Alloc a series of instances from memory pool.
@@ -61,6 +61,7 @@ class
   uint8_t *current_block_ = nullptr;
   // Size of each block is not fixed, but at least block_size_.
   std::list<std::pair<size_t, uint8_t *>> used_blocks_, available_blocks_;
+  TrackedMemory memory_;
 };
 
 }  // namespace TRay
\ No newline at end of file
@@ -3,8 +3,15 @@
 #include "core/geometry/Point.h"
 #include "core/Camera.h"
 #include "core/math/RNG.h"
+#include "core/statistics.h"
 
 namespace TRay {
+/// @brief Number of 1D and 2D values of a sample vector.
+struct SampleDimensions {
+  int n_1D = 0, n_2D = 0;
+};
+class BlueNoiseMask;
+
 class Sampler {
  public:
   virtual ~Sampler(){};
@@ -36,6 +43,9 @@ class Sampler {
   const Point2f *get_2D_array(int n);
   /// @brief Get the best number of samples over given number.
   virtual int round(int n) { return n; }
+  /// @brief Prepare for sample vectors of @param dims values, as the
+  ///        integrator expects before rendering.
+  virtual void reserve_dimensions(const SampleDimensions &) {}
   /// @brief Start next sample.
   /// @return true until the spp is exceeded.
   virtual bool next_sample();
@@ -45,6 +55,13 @@ class Sampler {
   /// @brief Clone a sampler with the same strategy but different random seed.
   virtual std::unique_ptr<Sampler> clone(int seed) const = 0;
   int64_t current_sample_index() const { return m_idx_current_pixel_sample; }
+  /// @brief Dither the sample vectors by @param mask, nullptr to stop.
+  ///        Pixels then draw the same values, shifted modulo 1 by the mask
+  ///        at the pixel, so that the error at low spp is blue noise. The
+  ///        point on film is left as it is.
+  void set_blue_noise(std::shared_ptr<const BlueNoiseMask> mask) {
+    m_blue_noise = std::move(mask);
+  }
 
   const int64_t m_spp;
 
@@ -56,6 +73,16 @@ class Sampler {
   std::vector<std::vector<Point2f>> m_sample_2D_array;
   Point2i m_current_pixel;
   int64_t m_idx_current_pixel_sample;
+  // Bytes of all sample arrays, for memory statistics.
+  TrackedMemory m_memory;
+  std::shared_ptr<const BlueNoiseMask> m_blue_noise;
+
+  /// @brief Shift @param u by the mask value of dimension @param dim at the
+  ///        current pixel, modulo 1.
+  Float dither(Float u, int dim) const;
+  /// @brief Shift each array of the current pixel as a whole, keeping the
+  ///        stratification of its values.
+  void dither_arrays();
 
  private:
   /// @brief Offset for both array size and corresponding array.
@@ -65,18 +92,36 @@ class Sampler {
 /**
  * @brief Samplers that generates definite numbers of samples.
  *        Number of dimensions will not be known until the ray goes into the
- *        scene. Uniform random values will be returned if number of dimensions
- *        is exceeded.
+ *        scene. The tables are sized by reserve_dimensions() and extended
+ *        when a path goes deeper, uniform random values will be returned
+ *        beyond MaxDimensions.
+ *        The values of a dimension are generated for all samples of the pixel
+ *        the first time it is used, paths ending early leave the deeper
+ *        dimensions untouched.
  */
 class PixelSampler : public Sampler {
  public:
   PixelSampler(int64_t samples_per_pxiel, int sample_dims);
+  void start_pixel(const Point2i &p) override;
   bool next_sample() override;
   bool set_sample_index(int64_t idx) override;
   Float sample_1D() override;
   Point2f sample_2D() override;
+  void reserve_dimensions(const SampleDimensions &dims) override;
+
+  // Dimensions of each kind stop growing here.
+  static constexpr int MaxDimensions = 256;
 
  protected:
+  /// @brief Fill the arrays for all samples of the current pixel.
+  ///        Uniform random values by default.
+  virtual void fill_arrays();
+  /// @brief Fill m_sample_1D[dim] for all samples of the current pixel.
+  ///        Uniform random values by default.
+  virtual void fill_1D(int dim);
+  /// @brief Fill m_sample_2D[dim] for all samples of the current pixel.
+  virtual void fill_2D(int dim);
+
   // Sample values for MULTIPLE samples in ONE pixel.
   // Layout: m_samplexD[dim_idx][sample_idx].
   // The sizes are all m_spp.
@@ -84,12 +129,21 @@ class PixelSampler : public Sampler {
   std::vector<std::vector<Point2f>> m_sample_2D;
   // Indexing the corresponding array in m_sample_[12]D.
   int m_idx_current_1D = 0, m_idx_current_2D = 0;
+  // Dimensions are used in order, those before these are filled.
+  int m_n_filled_1D = 0, m_n_filled_2D = 0;
   RNG m_rng;
+
+ private:
+  /// @brief Add tables up to @param n_1D and @param n_2D dimensions, at most
+  ///        MaxDimensions.
+  void add_dimensions(int n_1D, int n_2D);
 };
 
 /**
  * @brief GlobalSampler is to convert image-range sequences into pixel-by-pixel
  *        range, so that the pixel-tile based multi-therading will be easy.
+ *        Dithered, the dimensions after the point on film are taken at the
+ *        sample index in the pixel instead, the same for all pixels.
  */
 class GlobalSampler : public Sampler {
  public:
@@ -105,6 +159,18 @@ class GlobalSampler : public Sampler {
   ///         first 2 dimension.
   virtual Float value_by_dimension(int64_t global_idx_sample,
                                    int idx_dim) const = 0;
+  /// @brief Values of dimensions [@param idx_dim, + @param n) of a sample.
+  virtual void values_by_dimension(int64_t global_idx_sample, int idx_dim,
+                                   int n, Float *values) const {
+    for (int i = 0; i < n; i++)
+      values[i] = value_by_dimension(global_idx_sample, idx_dim + i);
+  }
+  /// @brief Global index of @param local_index, given the global index of
+  ///        local_index - 1. For sequences that step faster than
+  ///        global_index().
+  virtual int64_t next_global_index(int64_t, int64_t local_index) const {
+    return global_index(local_index);
+  }
   void start_pixel(const Point2i &p) override;
   bool next_sample() override;
   bool set_sample_index(int64_t idx) override;
@@ -14,25 +14,16 @@
 #include <utility>
 #include <vector>
 
+#include "core/logging.h"
+
 #ifdef TRAY_FLOAT_AS_DOUBLE
 using Float = double;
 #else
 using Float = float;
 #endif
 
-// Logging and assert warp
+// Assert warp. Logging macros are in core/logging.h.
 #define ASSERT(x) assert((x))
-#define PEEK(x) std::cerr << #x << ": " << x << "\n";
-#define SInfo(msg) std::cerr << "[I]" << msg << "\n"
-#define SWarn(msg) std::cerr << "-[W]" << msg << "\n"
-#define SError(msg) std::cerr << "--[E]" << msg << "\n"
-#define SCritical(msg) std::cerr << "----[C]" << msg << "\n"
-
-#ifndef NDEBUG
-#define SDebug(msg) std::cerr << "[D]" << msg << "\n"
-#else
-#define SDebug(msg) std::cerr << msg << "\n"
-#endif
 
 // Platform.
 #if defined(_WIN32) || defined(_WIN64)
@@ -0,0 +1,68 @@
+/**
+ * @file checkpoint.h
+ * @brief Periodic checkpoints of a film rendered tile by tile.
+ *
+ * A checkpoint holds the film pixels (weighted rgb sums and filter weight
+ * sums) and which tiles have been merged into them. Each tile takes its
+ * sampler from Sampler::clone with the tile index as seed, so the sampler
+ * state is implied by the tile: a resumed render draws the same samples for
+ * the remaining tiles and merges them in the same order onto the restored
+ * sums, giving the image of an uninterrupted render bit for bit.
+ *
+ * Layout, in native byte order:
+ *   FilmCheckpointHeader
+ *   uint8_t done[n_tiles]
+ *   Pixel[width * height], from 16 bytes after the header and flags.
+ */
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <future>
+#include <string>
+#include <vector>
+
+#include "core/Film.h"
+#include "core/TRay.h"
+
+namespace TRay {
+struct FilmCheckpointHeader {
+  char magic[4];
+  uint32_t version;
+  uint32_t float_size;
+  uint32_t n_tiles;
+  int32_t width;
+  int32_t height;
+  // Identity of the scene and the files it references.
+  uint64_t key;
+};
+
+class FilmCheckpoint {
+ public:
+  /// @param interval Seconds between two checkpoints.
+  /// @param key Identity of the render, a checkpoint with another key is
+  ///        ignored.
+  FilmCheckpoint(const std::string &path, double interval, uint64_t key)
+      : m_path(path), m_interval(interval), m_key(key) {}
+  /// @brief Waits for the write in flight.
+  ~FilmCheckpoint();
+  /// @brief Restore the pixels of @param film and the merged tiles from the
+  ///        checkpoint file, if it matches.
+  /// @param done One flag for each tile, set for the restored ones.
+  /// @return Number of restored tiles.
+  int resume(Film *film, std::vector<uint8_t> *done);
+  /// @brief Called after each merged tile. Once the interval has passed,
+  ///        copies the state and writes it from a background thread. Skips
+  ///        the checkpoint if the previous one is still being written.
+  void tile_done(const Film &film, const std::vector<uint8_t> &done);
+  /// @brief The render is complete, remove the checkpoint.
+  void finish();
+
+ private:
+  std::string m_path;
+  double m_interval;
+  uint64_t m_key;
+  std::chrono::steady_clock::time_point m_last =
+      std::chrono::steady_clock::now();
+  std::future<bool> m_pending;
+};
+}  // namespace TRay
@@ -0,0 +1,22 @@
+/**
+ * @file fileio.h
+ * @brief Identity and atomic replacement of files written by the renderer,
+ *        such as caches and checkpoints.
+ */
+#pragma once
+#include <cstdint>
+#include <string>
+
+#include "core/TRay.h"
+
+namespace TRay {
+/// @brief Size and modification time of a file.
+bool file_identity(const std::string &path, uint64_t *size, int64_t *mtime);
+/// @brief A path next to @param path, unique among the threads and processes
+///        using the same path.
+std::string temp_path(const std::string &path);
+/// @brief Write @param size bytes to @param path. The file is written aside
+///        and renamed, readers never see a partial file.
+bool write_file_replacing(const std::string &path, const void *data,
+                          size_t size);
+}  // namespace TRay
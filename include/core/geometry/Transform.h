@@ -47,6 +47,10 @@ class Transform {
   bool operator!=(const Transform &other) const { return !(*this == other); }
   bool is_identity() const;
   bool has_scale() const;
+  /// @brief true if this is a translation after a positive uniform scale.
+  /// @param translation Store the translation.
+  /// @param scale Store the scale factor.
+  bool is_translate_uniform_scale(Vector3f *translation, Float *scale) const;
   bool will_swap_hand() const;
   Transform inverse() const;
   // Transform apply.
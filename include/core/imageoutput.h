@@ -0,0 +1,51 @@
+/**
+ * @file imageoutput.h
+ * @brief Background output stage for rendered films.
+ *
+ * Rows of the film are converted to 8 bits on the output thread as soon as
+ * the integrator reports them final, and the image is encoded there once
+ * the render is done. Jobs hold the film, so the caller can go on loading
+ * and rendering the next scene while the previous one is written.
+ */
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "core/Film.h"
+#include "core/TRay.h"
+
+namespace TRay {
+/// @brief Films named *.pfm are written as linear float images.
+bool is_float_image(const std::string &filename);
+
+class ImageOutput {
+ public:
+  ImageOutput();
+  /// @brief Waits for the pending images.
+  ~ImageOutput();
+  /// @brief Start collecting the rows of @param film, before rendering it.
+  void begin(const std::shared_ptr<Film> &film);
+  /// @brief Queue the encoding of the film into its m_filename, after
+  ///        rendering it. Returns at once.
+  void finish();
+  /// @brief Wait until every queued job is done.
+  void wait();
+
+ private:
+  void push(std::function<void()> job);
+  void run();
+
+  std::shared_ptr<Film> m_film;
+  std::shared_ptr<std::vector<uint8_t>> m_image;
+  std::mutex m_mutex;
+  std::condition_variable m_cv_work, m_cv_done;
+  std::deque<std::function<void()>> m_jobs;
+  uint64_t m_pushed = 0, m_done = 0;
+  bool m_stop = false;
+  std::thread m_thread;
+};
+}  // namespace TRay
\ No newline at end of file
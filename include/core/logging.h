@@ -0,0 +1,136 @@
+/**
+ * @file logging.h
+ * @brief Leveled, rate-limited and asynchronous logging behind the SInfo,
+ *        SWarn, SError, SCritical and SDebug macros.
+ *
+ *        - Levels below TRAY_LOG_LEVEL are compiled out, their messages are
+ *          never even built.
+ *        - Each warning or error call site prints its first kLogBurst
+ *          messages, then only the 2^k-th ones, so a warning in a per-sample
+ *          loop costs one atomic increment once it is muted. Muted counts are
+ *          reported on flush.
+ *        - Lines are written to std::cerr by a background thread. Errors
+ *          and critical messages flush the queue before returning, and
+ *          queued lines are written on std::terminate() or abort().
+ */
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <sstream>
+#include <string>
+
+#define TRAY_LOG_LEVEL_DEBUG 0
+#define TRAY_LOG_LEVEL_INFO 1
+#define TRAY_LOG_LEVEL_WARNING 2
+#define TRAY_LOG_LEVEL_ERROR 3
+#define TRAY_LOG_LEVEL_CRITICAL 4
+#define TRAY_LOG_LEVEL_OFF 5
+
+#ifndef TRAY_LOG_LEVEL
+#ifdef NDEBUG
+#define TRAY_LOG_LEVEL TRAY_LOG_LEVEL_INFO
+#else
+#define TRAY_LOG_LEVEL TRAY_LOG_LEVEL_DEBUG
+#endif
+#endif
+
+namespace TRay {
+enum class LogLevel {
+  Debug = TRAY_LOG_LEVEL_DEBUG,
+  Info = TRAY_LOG_LEVEL_INFO,
+  Warning = TRAY_LOG_LEVEL_WARNING,
+  Error = TRAY_LOG_LEVEL_ERROR,
+  Critical = TRAY_LOG_LEVEL_CRITICAL
+};
+
+/// @brief Number of messages printed by one call site before rate limiting.
+static constexpr int64_t kLogBurst = 8;
+
+/// @brief Per call site state, one static instance for each log macro.
+class LogSite {
+ public:
+  constexpr LogSite(const char *file, int line) : m_file(file), m_line(line) {}
+  /// @brief Count one message.
+  /// @param limited Whether rate limiting applies, for warnings and above.
+  /// @return The occurrence index if it should be printed, -1 otherwise.
+  int64_t hit(bool limited) {
+    int64_t n = m_count.fetch_add(1, std::memory_order_relaxed);
+    if (!limited || n < kLogBurst || (n & (n + 1)) == 0) return n;
+    if (!m_muted.exchange(true, std::memory_order_relaxed)) register_muted();
+    return -1;
+  }
+  int64_t count() const { return m_count.load(std::memory_order_relaxed); }
+  const char *m_file;
+  const int m_line;
+  /// @brief Let this site be reported as muted again.
+  void reset_muted() { m_muted.store(false, std::memory_order_relaxed); }
+
+ private:
+  /// @brief Remember this site so that its muted count gets reported.
+  void register_muted();
+
+  std::atomic<int64_t> m_count{0};
+  std::atomic<bool> m_muted{false};
+};
+
+/// @brief Queue a formatted message for the writer thread.
+/// @param n The occurrence index returned by LogSite::hit().
+void log_message(LogLevel level, const LogSite &site, int64_t n,
+                 const std::string &msg);
+/// @brief Block until all queued messages are written, then report call sites
+///        that were muted since last flush.
+void log_flush();
+
+namespace detail {
+/// @brief Accepts anything streamable, as the old macros did.
+template <typename T>
+inline std::string to_log_string(const T &msg) {
+  std::ostringstream os;
+  os << msg;
+  return os.str();
+}
+inline std::string to_log_string(const std::string &msg) { return msg; }
+inline std::string to_log_string(const char *msg) { return msg; }
+}  // namespace detail
+}  // namespace TRay
+
+#define TRAY_LOG(level, msg)                                    \
+  do {                                                          \
+    static TRay::LogSite tray_log_site(__FILE__, __LINE__);     \
+    bool tray_log_limited = (level) >= TRay::LogLevel::Warning; \
+    int64_t tray_log_n = tray_log_site.hit(tray_log_limited);   \
+    if (tray_log_n >= 0)                                        \
+      TRay::log_message((level), tray_log_site, tray_log_n,     \
+                        TRay::detail::to_log_string(msg));      \
+  } while (0)
+#define TRAY_LOG_DISABLED(msg) \
+  do {                         \
+  } while (0)
+
+#if TRAY_LOG_LEVEL <= TRAY_LOG_LEVEL_DEBUG
+#define SDebug(msg) TRAY_LOG(TRay::LogLevel::Debug, msg)
+#define PEEK(x) SDebug(#x ": " + TRay::detail::to_log_string(x))
+#else
+#define SDebug(msg) TRAY_LOG_DISABLED(msg)
+#define PEEK(x) TRAY_LOG_DISABLED(x)
+#endif
+#if TRAY_LOG_LEVEL <= TRAY_LOG_LEVEL_INFO
+#define SInfo(msg) TRAY_LOG(TRay::LogLevel::Info, msg)
+#else
+#define SInfo(msg) TRAY_LOG_DISABLED(msg)
+#endif
+#if TRAY_LOG_LEVEL <= TRAY_LOG_LEVEL_WARNING
+#define SWarn(msg) TRAY_LOG(TRay::LogLevel::Warning, msg)
+#else
+#define SWarn(msg) TRAY_LOG_DISABLED(msg)
+#endif
+#if TRAY_LOG_LEVEL <= TRAY_LOG_LEVEL_ERROR
+#define SError(msg) TRAY_LOG(TRay::LogLevel::Error, msg)
+#else
+#define SError(msg) TRAY_LOG_DISABLED(msg)
+#endif
+#if TRAY_LOG_LEVEL <= TRAY_LOG_LEVEL_CRITICAL
+#define SCritical(msg) TRAY_LOG(TRay::LogLevel::Critical, msg)
+#else
+#define SCritical(msg) TRAY_LOG_DISABLED(msg)
+#endif
\ No newline at end of file
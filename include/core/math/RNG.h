@@ -66,13 +66,19 @@ inline uint32_t RNG::uniform_uint32() {
   uint32_t rot = (uint32_t)(oldstate >> 59u);
   return (xorshifted >> rot) | (xorshifted << ((~rot + 1u) & 31));
 }
+/// @see Lemire, Fast Random Integer Generation in an Interval, 2019.
 inline uint32_t RNG::uniform_uint32(uint32_t b) {
-  // Ensure the uniform.
-  uint32_t threshold = (~b + 1u) % b;
-  // Reject.
-  while (true) {
-    uint32_t r = uniform_uint32();
-    if (r >= threshold) return r % b;
+  // Multiply-shift, the high half is the result. Only the low half below b
+  // may need a reject, then the threshold is worth its modulo.
+  uint64_t m = uint64_t(uniform_uint32()) * b;
+  uint32_t low = uint32_t(m);
+  if (low < b) {
+    uint32_t threshold = (~b + 1u) % b;
+    while (low < threshold) {
+      m = uint64_t(uniform_uint32()) * b;
+      low = uint32_t(m);
+    }
   }
+  return uint32_t(m >> 32);
 }
 }  // namespace TRay
\ No newline at end of file
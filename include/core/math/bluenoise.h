@@ -0,0 +1,52 @@
+/**
+ * @file bluenoise.h
+ * @brief Tiled blue-noise masks, to dither the sample vectors of neighbouring
+ *        pixels so that their errors are spread as blue noise.
+ *
+ * A mask holds n_channels independent size x size tiles. Each tile ranks its
+ * pixels 0 .. size^2 - 1 so that the pixels below any threshold form a
+ * blue-noise point set, as made offline by void and cluster (TRay-BlueNoise).
+ *
+ * Layout, in native byte order:
+ *   BlueNoiseHeader
+ *   uint16_t rank[n_channels][size][size]
+ */
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "core/TRay.h"
+#include "core/geometry/Point.h"
+
+namespace TRay {
+struct BlueNoiseHeader {
+  char magic[4];
+  uint32_t version;
+  uint32_t size;
+  uint32_t n_channels;
+};
+
+class BlueNoiseMask {
+ public:
+  /// @param ranks Ranks of all channels, row by row, size * size each.
+  BlueNoiseMask(int size, int n_channels, std::vector<uint16_t> ranks);
+  /// @return nullptr if @param path is missing or not a mask.
+  static std::shared_ptr<const BlueNoiseMask> load(const std::string &path);
+  bool write(const std::string &path) const;
+  /// @brief Value in (0, 1) of dimension @param dim at pixel @param p.
+  ///        Dimensions take the channels in turn, then the same channels
+  ///        shifted by the R2 sequence, the tiles repeat over the image.
+  Float value(const Point2i &p, int dim) const;
+  int size() const { return m_size; }
+  int n_channels() const { return m_n_channels; }
+
+  // Ranks are stored in 16 bits.
+  static constexpr int MaxSize = 256;
+
+ private:
+  const int m_size, m_n_channels;
+  std::vector<uint16_t> m_ranks;
+};
+}  // namespace TRay
@@ -1,12 +1,38 @@
 #pragma once
+#include <memory>
+#include <vector>
+
 #include "core/TRay.h"
 #include "core/math/sampling.h"
 #include "core/geometry/Point.h"
 #include "core/math/SobolMatrices.h"
 
 namespace TRay {
+/// @brief Number of prime bases of radical_inverse().
+constexpr int NPrimes = 1024;
 /// @brief Get the inversed value of @param a based on @param base_idx-th prime.
 Float radical_inverse(int base_idx, uint64_t a);
+/// @brief Random permutations of the digits of each prime base, for
+///        scrambled_radical_inverse(). Every digit position of a base uses
+///        the same permutation.
+class DigitPermutations {
+ public:
+  /// @brief Permutations of all NPrimes bases, drawn from @param rng.
+  DigitPermutations(RNG &rng);
+  /// @brief Permutation of the @param base_idx-th prime, followed by its
+  ///        digit tables if the base is small.
+  const uint16_t *tables(int base_idx) const {
+    return m_tables.data() + m_offsets[base_idx];
+  }
+
+ private:
+  std::vector<uint16_t> m_tables;
+  std::vector<size_t> m_offsets;
+};
+/// @brief radical_inverse() with each digit of @param a permuted by
+///        @param perms.
+Float scrambled_radical_inverse(int base_idx, uint64_t a,
+                                const DigitPermutations &perms);
 /// @brief Restore the inverse_digits in function radical_inverse().
 /// @param inverse_digits
 /// @param n_digits Length of original value, for restoring zeros.
@@ -21,6 +47,36 @@ inline uint64_t radical_inverse_inv(uint64_t inverse_digits, int n_digits) {
   }
   return index;
 }
+inline uint32_t reverse_bit32(uint32_t n) {
+  n = (n << 16) | (n >> 16);
+  n = ((n & 0x00ff00ff) << 8) | ((n & 0xff00ff00) >> 8);
+  n = ((n & 0x0f0f0f0f) << 4) | ((n & 0xf0f0f0f0) >> 4);
+  n = ((n & 0x33333333) << 2) | ((n & 0xcccccccc) >> 2);
+  n = ((n & 0x55555555) << 1) | ((n & 0xaaaaaaaa) >> 1);
+  return n;
+}
+/// @brief Finalizer of MurmurHash3, every bit of @param v affects every bit
+///        of the result.
+inline uint64_t mix_bits(uint64_t v) {
+  v ^= v >> 31;
+  v *= 0x7fb5d329728ea185;
+  v ^= v >> 27;
+  v *= 0x81dadef4bc2dd44d;
+  v ^= v >> 33;
+  return v;
+}
+/// @brief Owen scramble the bits of @param v, the flip of each bit depends on
+///        the higher ones and @param seed.
+/// @see Burley, Practical Hash-based Owen Scrambling, JCGT 2020.
+inline uint32_t owen_scramble(uint32_t v, uint32_t seed) {
+  v = reverse_bit32(v);
+  v ^= v * 0x3d20adea;
+  v += seed;
+  v *= (seed >> 16) | 1;
+  v ^= v * 0x05526c56;
+  v ^= v * 0x53a22864;
+  return reverse_bit32(v);
+}
 /// @brief Perform a multiply of Ca.
 /// @param C The first column of 32x32 generator matrix.
 /// @param a The number to be "radical-inversed".
@@ -72,62 +128,61 @@ inline void fill_sample_by_graycode(const uint32_t *C0, const uint32_t *C1,
     v[1] ^= C1[ctz(i + 1)];
   }
 }
+/// @brief The (0, 2)-sequence in Gray code order, unscrambled: the van der
+///        Corput values and those of the second Sobol' dimension. A random
+///        digital shift of it is the same as filling by Gray code from the
+///        shift, so it is built once by a sampler and shared read-only by
+///        its clones. The first n values serve any power of 2 n up to size().
+class ZeroTwoTable {
+ public:
+  /// @param n Number of values, a power of 2.
+  explicit ZeroTwoTable(uint32_t n);
+  uint32_t size() const { return uint32_t(m_x.size()); }
+  /// @brief Van der Corput values.
+  const uint32_t *x() const { return m_x.data(); }
+  /// @brief Values of the second dimension.
+  const uint32_t *y() const { return m_y.data(); }
+
+ private:
+  std::vector<uint32_t> m_x, m_y;
+};
+/// @brief Replace @param table by a larger one unless it holds @param n
+///        values.
+inline void fit_table(std::shared_ptr<const ZeroTwoTable> &table, uint32_t n) {
+  if (!table || table->size() < n)
+    table = std::make_shared<const ZeroTwoTable>(pow2_ceil(int32_t(n)));
+}
+/// @brief Scrambled van der Corput values for @param n_pxl_samples samples of
+///        @param n_sub_samples each, shuffled within and across samples.
 inline void fill_VDCorput_1D(int n_sub_samples, int n_pxl_samples,
-                             Float *sample_values, RNG &rng) {
+                             const ZeroTwoTable &table, Float *sample_values,
+                             RNG &rng) {
   uint32_t scramble_bits = rng.uniform_uint32();
-  // Generator matrix. Identity.
-  const uint32_t CVanDerCorput[32] = {
-      // clang-format off
-      0x80000000, 0x40000000, 0x20000000, 0x10000000,
-      0x8000000,  0x4000000,  0x2000000,  0x1000000,
-      0x800000,   0x400000,   0x200000,   0x100000,
-      0x80000,    0x40000,    0x20000,    0x10000,
-      0x8000,     0x4000,     0x2000,     0x1000,
-      0x800,      0x400,      0x200,      0x100,
-      0x80,       0x40,       0x20,       0x10,
-      0x8,        0x4,        0x2,        0x1
-      // clang-format on
-  };
-  int n_total_samples = n_sub_samples * n_pxl_samples;
-  fill_sample_by_graycode(CVanDerCorput, n_total_samples, scramble_bits,
-                          sample_values);
+  uint32_t n_total_samples = uint32_t(n_sub_samples) * n_pxl_samples;
+  ASSERT(n_total_samples <= table.size());
+  const uint32_t *x = table.x();
+  for (uint32_t i = 0; i < n_total_samples; ++i)
+    sample_values[i] = (x[i] ^ scramble_bits) * 0x1p-32f;
   // Shuffle to cancel the correlation.
   for (int i = 0; i < n_pxl_samples; ++i)
     shuffle(sample_values + i * n_sub_samples, n_sub_samples, 1, rng);
   shuffle(sample_values, n_pxl_samples, n_sub_samples, rng);
 }
+/// @brief 2D version, the (0, 2)-sequence.
 inline void fill_Sobol_2D(int n_sub_samples, int n_pxl_samples,
-                          Point2f *sample_values, RNG &rng) {
-  Point2i scramble;
-  scramble[0] = rng.uniform_uint32();
-  scramble[1] = rng.uniform_uint32();
-  // Two matrices.
-  const uint32_t CSobol[2][32] = {
-      // clang-format off
-      {
-        0x80000000, 0x40000000, 0x20000000, 0x10000000, 
-        0x8000000,  0x4000000,  0x2000000,  0x1000000,
-        0x800000,   0x400000,   0x200000,   0x100000,
-        0x80000,    0x40000,    0x20000,    0x10000,
-        0x8000,     0x4000,     0x2000,     0x1000,
-        0x800,      0x400,      0x200,      0x100,
-        0x80,       0x40,       0x20,       0x10,
-        0x8,        0x4,        0x2,        0x1
-      },
-      {
-        0x80000000, 0xc0000000, 0xa0000000, 0xf0000000,
-        0x88000000, 0xcc000000, 0xaa000000, 0xff000000, 
-        0x80800000, 0xc0c00000, 0xa0a00000, 0xf0f00000,
-        0x88880000, 0xcccc0000, 0xaaaa0000, 0xffff0000, 
-        0x80008000, 0xc000c000, 0xa000a000, 0xf000f000,
-        0x88008800, 0xcc00cc00, 0xaa00aa00, 0xff00ff00,
-        0x80808080, 0xc0c0c0c0, 0xa0a0a0a0, 0xf0f0f0f0, 
-        0x88888888, 0xcccccccc, 0xaaaaaaaa, 0xffffffff
-      }
-      // clang-format on
-  };
-  fill_sample_by_graycode(CSobol[0], CSobol[1], n_sub_samples * n_pxl_samples,
-                          scramble, sample_values);
+                          const ZeroTwoTable &table, Point2f *sample_values,
+                          RNG &rng) {
+  uint32_t scramble_x = rng.uniform_uint32();
+  uint32_t scramble_y = rng.uniform_uint32();
+  uint32_t n_total_samples = uint32_t(n_sub_samples) * n_pxl_samples;
+  ASSERT(n_total_samples <= table.size());
+  const uint32_t *x = table.x(), *y = table.y();
+  for (uint32_t i = 0; i < n_total_samples; ++i) {
+    sample_values[i].x =
+        std::min((x[i] ^ scramble_x) * Float(0x1p-32), ONE_M_EPS);
+    sample_values[i].y =
+        std::min((y[i] ^ scramble_y) * Float(0x1p-32), ONE_M_EPS);
+  }
   // Shuffle to cancel the correlation.
   for (int i = 0; i < n_pxl_samples; ++i)
     shuffle(sample_values + i * n_sub_samples, n_sub_samples, 1, rng);
@@ -159,6 +214,24 @@ inline uint64_t global_index_Sobol(const uint32_t expo, uint64_t local_idx,
   return index;
 }
 
+/// @brief Leading dimensions evaluated through byte tables.
+static constexpr int NSobolTableDimensions = 64;
+/// @brief Bytes of the sample index covered by the byte tables.
+static constexpr int NSobolTableBytes = (SobolMatrixSize + 7) / 8;
+/**
+ * @brief XOR of the Sobol' matrix columns selected by each byte of a sample
+ *        index, so that 8 bits are applied with one lookup. Laid out as
+ *        [byte of index][byte value][dimension]: one byte of the index
+ *        updates consecutive dimensions with one vectorizable loop.
+ *        Built on first use.
+ */
+const uint32_t *Sobol_table32();
+const uint64_t *Sobol_table64();
+/// @brief Entry of byte @param g with value @param byte_val for dimension 0.
+inline size_t Sobol_table_offset(int g, uint64_t byte_val) {
+  return (g * 256 + byte_val) * NSobolTableDimensions;
+}
+
 inline float sample_Sobol_float(int64_t a, int dimension, uint32_t scramble);
 inline float sample_Sobol_double(int64_t a, int dimension, uint32_t scramble);
 inline Float sample_Sobol(int64_t global_index, int dimension,
@@ -169,15 +242,30 @@ inline Float sample_Sobol(int64_t global_index, int dimension,
   return sample_Sobol_float(global_index, dimension, scramble);
 #endif
 }
+/// @brief Sample values of dimensions [@param dimension, + @param n) for the
+///        same index, equal to calling sample_Sobol for each.
+void sample_Sobol(int64_t global_index, int dimension, int n, Float *values,
+                  uint64_t scramble = 0);
+/// @brief Bits of sample @param a of the @param dimension-th Sobol'
+///        sequence, which must be below NSobolDimensions.
+inline uint32_t Sobol_bits32(int64_t a, int dimension) {
+  uint32_t v = 0;
+  if (dimension < NSobolTableDimensions) {
+    const uint32_t *table = Sobol_table32() + dimension;
+    for (int g = 0; a != 0 && g < NSobolTableBytes; a >>= 8, ++g)
+      v ^= table[Sobol_table_offset(g, a & 0xff)];
+    return v;
+  }
+  for (int i = dimension * SobolMatrixSize; a != 0; a >>= 1, ++i)
+    if (a & 1) v ^= SobolMatrices32[i];
+  return v;
+}
 inline float sample_Sobol_float(int64_t a, int dimension, uint32_t scramble) {
   if (dimension >= NSobolDimensions) {
     SWarn("sample_Sobol_float: dimension index exceeded, zero is returned.");
     return 0;
   }
-  uint32_t v = scramble;
-  for (int i = dimension * SobolMatrixSize; a != 0; a >>= 1, ++i)
-    if (a & 1) v ^= SobolMatrices32[i];
-  return v * 0x1p-32f;
+  return (Sobol_bits32(a, dimension) ^ scramble) * 0x1p-32f;
 }
 inline float sample_Sobol_double(int64_t a, int dimension, uint32_t scramble) {
   if (dimension >= NSobolDimensions) {
@@ -189,6 +277,12 @@ inline float sample_Sobol_double(int64_t a, int dimension, uint32_t scramble) {
   }
   // TODO Why bitwise-and?
   uint64_t result = scramble & ~-(1ll << SobolMatrixSize);
+  if (dimension < NSobolTableDimensions) {
+    const uint64_t *table = Sobol_table64() + dimension;
+    for (int g = 0; a != 0 && g < NSobolTableBytes; a >>= 8, ++g)
+      result ^= table[Sobol_table_offset(g, a & 0xff)];
+    return std::min(result * (1.0 / (1ull << SobolMatrixSize)), ONE_M_EPS);
+  }
   for (int i = dimension * SobolMatrixSize; a != 0; a >>= 1, i++)
     if (a & 1) result ^= SobolMatrices64[i];
   return std::min(result * (1.0 / (1ull << SobolMatrixSize)), ONE_M_EPS);
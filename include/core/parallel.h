@@ -0,0 +1,51 @@
+/**
+ * @file parallel.h
+ * @brief Fork-join loop over independent work items.
+ */
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <thread>
+#include <vector>
+
+#include "core/TRay.h"
+#include "core/statistics.h"
+
+namespace TRay {
+/// @brief Whether this thread runs items of a parallel_for.
+inline thread_local bool in_parallel_for = false;
+
+/// @brief One thread per hardware thread.
+inline int n_system_threads() {
+  return int(std::max(1u, std::thread::hardware_concurrency()));
+}
+
+/// @brief Call @param func(i) for every i in [0, @param count), items handed
+///        out in order to up to @param n_threads threads, 0 for
+///        n_system_threads(). The calling thread takes part, the others
+///        report their statistics before exiting. Nested inside another
+///        parallel_for, the loop runs serially on the calling thread.
+inline void parallel_for(int64_t count,
+                         const std::function<void(int64_t)> &func,
+                         int n_threads = 0) {
+  if (n_threads <= 0) n_threads = n_system_threads();
+  if (in_parallel_for) n_threads = 1;
+  n_threads = int(std::min<int64_t>(n_threads, count));
+  std::atomic<int64_t> next{0};
+  auto work = [&] {
+    bool nested = in_parallel_for;
+    in_parallel_for = true;
+    for (int64_t i = next++; i < count; i = next++) func(i);
+    in_parallel_for = nested;
+  };
+  std::vector<std::thread> threads;
+  for (int t = 1; t < n_threads; t++)
+    threads.emplace_back([&] {
+      work();
+      ReportThreadStats();
+    });
+  work();
+  for (auto &thread : threads) thread.join();
+}
+}  // namespace TRay
\ No newline at end of file
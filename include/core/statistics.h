@@ -5,6 +5,7 @@
 /// @date 2023-10-21
 ///
 #pragma once
+#include <atomic>
 #include <functional>
 #include <map>
 #include <mutex>
@@ -52,11 +53,66 @@ class StatsAccumulator {
   void AccumulateCounter(const std::string &cat, const int64_t val) {
     m_counters[cat] += val;
   }
+  /// @brief Memory values are global already, so they are overwritten
+  ///        instead of summed up.
+  void ReportMemory(const std::string &cat, const int64_t live,
+                    const int64_t peak) {
+    m_memory[cat] = {live, peak};
+  }
   void Print(std::ostream &o);
   void Clear();
 
  private:
   std::map<std::string, int64_t> m_counters;
+  // Category -> {live bytes, peak bytes}.
+  std::map<std::string, std::pair<int64_t, int64_t>> m_memory;
+};
+
+/// @brief Live and peak bytes of one kind of memory.
+///        Memory is often freed by another thread than the one allocating it,
+///        so unlike counters this is a global atomic value.
+///        Every counter also charges the total of all kinds.
+class MemoryCounter {
+ public:
+  void allocate(int64_t bytes);
+  void free(int64_t bytes) { allocate(-bytes); }
+  int64_t live() const { return m_live.load(std::memory_order_relaxed); }
+  int64_t peak() const { return m_peak.load(std::memory_order_relaxed); }
+
+ private:
+  void update(int64_t bytes);
+
+  std::atomic<int64_t> m_live{0}, m_peak{0};
+};
+
+/// @brief Bytes owned by an object, charged to a MemoryCounter during its
+///        lifetime. Copies are charged again, so a class holding one keeps
+///        correct numbers with its default copy constructor.
+class TrackedMemory {
+ public:
+  TrackedMemory(MemoryCounter *counter = nullptr) : m_counter(counter) {}
+  TrackedMemory(const TrackedMemory &other) : m_counter(other.m_counter) {
+    set(other.m_bytes);
+  }
+  TrackedMemory &operator=(const TrackedMemory &other) {
+    if (this == &other) return *this;
+    set(0);
+    m_counter = other.m_counter;
+    set(other.m_bytes);
+    return *this;
+  }
+  ~TrackedMemory() { set(0); }
+  /// @brief Change the owned bytes to @param bytes.
+  void set(int64_t bytes) {
+    if (m_counter) m_counter->allocate(bytes - m_bytes);
+    m_bytes = bytes;
+  }
+  void add(int64_t bytes) { set(m_bytes + bytes); }
+  int64_t bytes() const { return m_bytes; }
+
+ private:
+  MemoryCounter *m_counter;
+  int64_t m_bytes = 0;
 };
 
 /// @brief Macros to use in each CPP FILE.
@@ -70,6 +126,14 @@ class StatsAccumulator {
     var = 0;                                                \
   }                                                         \
   static TRay::StatReporter STAT_REPORTER##var(STAT_CB##var);
+/// @brief Global live/peak memory counter, see MemoryCounter.
+///        Values are reported as they are when the stats are reported.
+#define STAT_MEMORY(category, var)                            \
+  static TRay::MemoryCounter var;                             \
+  static void STAT_CB##var(TRay::StatsAccumulator &accum) {   \
+    accum.ReportMemory(category, var.live(), var.peak());     \
+  }                                                           \
+  static TRay::StatReporter STAT_REPORTER##var(STAT_CB##var);
 
 // void TestFunc();
 }  // namespace TRay
\ No newline at end of file
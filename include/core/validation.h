@@ -0,0 +1,66 @@
+/**
+ * @file validation.h
+ * @brief Checks on the radiance returned by integrators.
+ */
+#pragma once
+#include <mutex>
+
+#include "core/TRay.h"
+#include "core/geometry/Bound.h"
+#include "core/geometry/Point.h"
+#include "core/spectrum/spectrum.h"
+
+namespace TRay {
+enum class RadianceIssue : uint8_t { None = 0, NaN = 1, Negative = 2, INF = 4 };
+
+/// @brief One offending sample.
+struct BadSample {
+  RadianceIssue issue;
+  Point2i pixel;
+  int64_t sample_index;
+};
+
+/**
+ * @brief Replaces bad radiance values by black and keeps track of them.
+ *        Valid values only pay for the luminance and two comparisons, all the
+ *        bookkeeping is out of line:
+ *        - Per-issue counters in the statistics.
+ *        - The first kMaxRecords offending samples.
+ *        - A per-pixel mask of issues, allocated on the first bad sample.
+ */
+class RadianceValidator {
+ public:
+  static constexpr int kMaxRecords = 32;
+  /// @brief Start a new render.
+  /// @param pixel_bound Pixels covered by the mask.
+  void reset(const Bound2i &pixel_bound);
+  /// @brief Check @param L, set it to black if invalid.
+  /// @return false if @param L was invalid.
+  bool validate(Spectrum *L, const Point2i &pixel, int64_t sample_index) {
+    // NaN fails every comparison, INF of any channel makes y() INF or NaN.
+    Float y = L->y();
+    if (y >= -1e-5 && y < TRAY_INF) return true;
+    record(L, pixel, sample_index);
+    *L = Spectrum(0.f);
+    return false;
+  }
+  int64_t n_bad_samples() const { return m_n_bad; }
+  const std::vector<BadSample> &records() const { return m_records; }
+  /// @brief Log a summary with the recorded samples.
+  void report() const;
+  /// @brief Image of the bad pixels, RGBRGB... over the mask bound.
+  ///        Red for NaN, green for negative and blue for INF.
+  /// @return false if there was no bad sample.
+  bool bad_pixel_mask(std::vector<uint8_t> *rgb, Point2i *resolution) const;
+
+ private:
+  void record(const Spectrum *L, const Point2i &pixel, int64_t sample_index);
+
+  Bound2i m_pixel_bound;
+  mutable std::mutex m_mutex;
+  int64_t m_n_bad = 0;
+  std::vector<BadSample> m_records;
+  // Bitwise or of RadianceIssue, empty until the first bad sample.
+  std::vector<uint8_t> m_mask;
+};
+}  // namespace TRay
\ No newline at end of file
@@ -37,6 +37,7 @@ class DirectIntegrator : public SamplerIntegrator {
   void preprocess(const Scene &scene, Sampler &sampler) override;
   Spectrum Li(const Ray &ray, const Scene &scene, Sampler &sampler,
               int depth = 0) const override;
+  SampleDimensions sample_dimensions(const Scene &scene) const override;
 
  private:
   const LightSample m_light_sample;
@@ -22,6 +22,7 @@ class WhittedIntegrator : public SamplerIntegrator {
   }
   Spectrum Li(const Ray &ray, const Scene &scene, Sampler &sampler,
               int depth = 0) const override;
+  SampleDimensions sample_dimensions(const Scene &scene) const override;
 
  private:
   const int m_max_depth;
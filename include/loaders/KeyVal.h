@@ -36,6 +36,8 @@ const std::string Radius = "radius";
 const std::string Vertex = "vertex";
 const std::string Index = "index";
 const std::string File = "file";
+const std::string Reorder = "reorder";
+const std::string Cache = "cache";
 // Lights.
 const std::string Lights = "lights";
 const std::string Emit = "emit";
@@ -58,14 +60,19 @@ const std::string Resolution = "resolution";
 const std::string Crop = "crop";
 const std::string Filter = "filter";
 const std::string FilterRadius = "filter_radius";
+const std::string Checkpoint = "checkpoint";
 // Sampler.
 const std::string Sampler = "sampler";
 const std::string SamplePerPixel = "sample_per_pixel";
 const std::string SampleDimension = "sample_dimension";
 const std::string Jitter = "jitter";
+const std::string Scramble = "scramble";
+const std::string BlueNoise = "blue_noise";
 // Integrator
 const std::string Integrator = "integrator";
 const std::string MaxDepth = "max_depth";
+// Snapshot.
+const std::string Snapshot = "snapshot";
 
 }  // namespace Key
 
@@ -90,6 +97,9 @@ const std::string MirrorMaterial = "mirror";
 const std::string Sphere = "sphere";
 const std::string MeshPlain = "mesh_plain";
 const std::string MeshObj = "mesh_obj";
+const std::string None = "none";
+const std::string Morton = "morton";
+const std::string VertexCache = "vertex_cache";
 // Lights.
 const std::string DiffuseArea = "diffuse_area";
 const std::string Distant = "distant";
@@ -108,6 +118,7 @@ const std::string HaltonSampler = "halton";
 const std::string ZeroTwoSampler = "0,2-sequence";
 const std::string MaxMinDisSampler = "max_min_distance";
 const std::string SobolSampler = "sobol";
+const std::string ZSobolSampler = "zsobol";
 // Integrator
 const std::string PathIntegrator = "path";
 const std::string DirectIntegrator = "direct";
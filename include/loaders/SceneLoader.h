@@ -4,6 +4,7 @@
 #include "core/Camera.h"
 #include "core/Film.h"
 #include "loaders/meshloading.h"
+#include "loaders/scenesnapshot.h"
 #include <nlohmann/json_fwd.hpp>
 
 namespace TRay {
@@ -14,12 +15,22 @@ class SceneLoader {
   std::shared_ptr<Scene> get_scene() const { return m_scene; }
   std::shared_ptr<Integrator> get_integrator() const { return m_integrator; }
   std::shared_ptr<Camera> get_camera() const { return m_camera; }
+  std::shared_ptr<Sampler> get_sampler() const { return m_sampler; }
   Vector2i get_resulotion() const {
     return m_camera ? m_camera->m_film->m_cropped_pixel_bound.diagonal()
                     : Vector2i(1, 1);
   }
   bool load(const char* path) { return reload(path); }
   bool reload(const char* path);
+  /// @brief Render part @param part of @param n_parts of the samples of the
+  ///        scenes loaded from now on, see Integrator::set_sample_part.
+  void set_sample_part(int part, int n_parts) {
+    m_sample_part = part;
+    m_sample_parts = n_parts;
+  }
+  /// @brief Mesh files the world of @param scene_file depends on.
+  static std::vector<std::string> referenced_files(
+      const nlohmann::json& scene_file);
 
  private:
   std::string m_file_path;
@@ -30,6 +41,7 @@ class SceneLoader {
   std::shared_ptr<Camera> m_camera = nullptr;
   std::shared_ptr<Sampler> m_sampler = nullptr;
   std::shared_ptr<Integrator> m_integrator = nullptr;
+  int m_sample_part = 0, m_sample_parts = 1;
 
 #define VEC_OF_SHARED(T) std::vector<std::shared_ptr<T>>
   std::map<std::string, std::shared_ptr<Transform>> transforms;
@@ -40,6 +52,16 @@ class SceneLoader {
   std::map<std::string, std::shared_ptr<VEC_OF_SHARED(Shape)>> shapes;
   std::map<std::string, std::shared_ptr<VEC_OF_SHARED(AreaLight)>> alights;
 #undef VEC_OF_SHARED
+  // Inline mesh arrays kept out of the DOM, one for each shape, see
+  // sceneparser.h.
+  std::vector<MeshData> m_inline_meshes;
+  // Meshes of the shapes, see scenesnapshot.h. Either the snapshot is open
+  // or, when it is to be written, the meshes are gathered while loading.
+  SceneSnapshot m_snapshot;
+  bool m_write_snapshot = false;
+  uint64_t m_snapshot_key = 0;
+  std::vector<uint32_t> m_snapshot_owners;
+  std::vector<MeshData> m_snapshot_meshes;
 
   using json = nlohmann::json;
   bool do_transforms(const json& scene_file);
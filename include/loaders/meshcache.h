@@ -0,0 +1,122 @@
+/**
+ * @file meshcache.h
+ * @brief Binary cache of processed meshes, written next to the source file
+ *        and memory mapped on later loads.
+ *
+ * Layout, all in native byte order and 16-byte aligned blocks:
+ *   MeshCacheHeader
+ *   MeshCacheShape[n_shapes]
+ *   For each shape: vertices, normals (optional), uvs (optional), indices.
+ * Offsets in MeshCacheShape are from the beginning of the file.
+ */
+#pragma once
+#include <cstdint>
+#include <string>
+
+#include "core/TRay.h"
+#include "core/fileio.h"
+#include "loaders/meshprocessing.h"
+
+namespace TRay {
+struct MeshCacheHeader {
+  char magic[4];
+  uint32_t version;
+  // sizeof(Float) of the writer, caches are not shared between builds.
+  uint32_t float_size;
+  uint32_t order;
+  uint32_t n_shapes;
+  uint32_t padding;
+  // Identity of the source file.
+  uint64_t source_size;
+  int64_t source_mtime;
+  uint64_t source_hash;
+};
+struct MeshCacheShape {
+  uint32_t n_vertices;
+  uint32_t n_triangles;
+  uint32_t has_normals;
+  uint32_t has_uvs;
+  uint64_t vertices_offset, normals_offset, uvs_offset, indices_offset;
+};
+
+/// @brief Read-only view of a whole file, memory mapped if possible.
+class MappedFile {
+ public:
+  MappedFile() = default;
+  ~MappedFile() { close(); }
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+  bool open(const std::string &path);
+  void close();
+  const uint8_t *data() const { return m_data; }
+  size_t size() const { return m_size; }
+
+ private:
+  const uint8_t *m_data = nullptr;
+  size_t m_size = 0;
+#ifdef TRAY_ON_WINDOWS
+  void *m_file = nullptr, *m_mapping = nullptr;
+#endif
+};
+
+/**
+ * @brief Meshes stored as a MeshCacheShape table followed by their arrays,
+ *        as in mesh caches and scene snapshots. Arrays point into the
+ *        underlying file.
+ */
+class MeshBlocks {
+ public:
+  int n_shapes() const { return int(m_n_shapes); }
+  const MeshCacheShape &shape(int i) const { return m_shapes[i]; }
+  const Point3f *vertices(int i) const;
+  /// @brief nullptr if the shape has no normals.
+  const Normal3f *normals(int i) const;
+  /// @brief nullptr if the shape has no uvs.
+  const Point2f *uvs(int i) const;
+  const int *indices(int i) const;
+
+  /// @brief Place the table of @param meshes at @param table_offset and
+  ///        their arrays after it.
+  /// @return End of the last array.
+  static uint64_t layout(const std::vector<MeshData> &meshes,
+                         uint64_t table_offset,
+                         std::vector<MeshCacheShape> *table);
+  /// @brief Copy the table and arrays into the file image @param image.
+  static void fill(const std::vector<MeshData> &meshes, uint64_t table_offset,
+                   const std::vector<MeshCacheShape> &table, uint8_t *image);
+
+ protected:
+  /// @brief View the @param n_shapes shapes of the table at
+  ///        @param table_offset in @param file.
+  /// @return false if the table or an array is outside of the file, or an
+  ///         index is not a vertex of its shape.
+  bool view(const MappedFile &file, uint64_t table_offset, uint32_t n_shapes);
+  void clear_view();
+
+ private:
+  template <typename T>
+  const T *at(uint64_t offset) const {
+    return reinterpret_cast<const T *>(m_data + offset);
+  }
+
+  const uint8_t *m_data = nullptr;
+  const MeshCacheShape *m_shapes = nullptr;
+  uint32_t m_n_shapes = 0;
+};
+
+/// @brief A loaded mesh cache.
+class MeshCache : public MeshBlocks {
+ public:
+  /// @brief Where the cache of @param source_path lives.
+  static std::string cache_path(const std::string &source_path);
+  /// @brief Map the cache of @param source_path if it is up to date.
+  bool open(const std::string &source_path, MeshOrder order);
+
+  /// @brief Write @param meshes as the cache of @param source_path.
+  static bool write(const std::string &source_path, MeshOrder order,
+                    const std::vector<MeshData> &meshes);
+
+ private:
+  MappedFile m_file;
+};
+}  // namespace TRay
\ No newline at end of file
@@ -1,9 +1,20 @@
 #pragma once
 #include "core/TRay.h"
+#include "loaders/meshprocessing.h"
 
 namespace TRay {
+/// @brief Load all shapes in an OBJ file as triangles, see load_mesh_data.
+/// @param order Locality order applied to each shape after compaction.
+/// @param use_cache Load from and write to the binary cache next to
+///        @param filename, see meshcache.h.
 
 bool load_triangle_mesh(const Transform& obj_to_world, bool flip_normal,
                         std::vector<std::shared_ptr<Shape>>* triangles,
-                        const char* filename, const char* basepath = NULL);
+                        const char* filename, const char* basepath = NULL,
+                        MeshOrder order = MeshOrder::None,
+                        bool use_cache = true);
+/// @brief Load all shapes in an OBJ file as compacted meshes in object
+///        space.
+bool load_mesh_data(const char* filename, MeshOrder order, bool use_cache,
+                    std::vector<MeshData>* meshes);
 }  // namespace TRay
\ No newline at end of file
@@ -0,0 +1,48 @@
+#pragma once
+#include "core/TRay.h"
+#include "core/geometry/Normal.h"
+#include "core/geometry/Point.h"
+
+namespace TRay {
+/// @brief Plain triangle mesh buffers in object space, before they are handed
+///        to create_triangle_mesh().
+struct MeshData {
+  std::vector<Point3f> vertices;
+  /// @brief Optional. Empty or one for each vertex.
+  std::vector<Normal3f> normals;
+  /// @brief Optional. Empty or one for each vertex.
+  std::vector<Point2f> uvs;
+  /// @brief Three for each triangle. Layout: [t0_0, t0_1, t0_2, t1_0, ...].
+  std::vector<int> indices;
+
+  int n_triangles() const { return int(indices.size() / 3); }
+  int n_vertices() const { return int(vertices.size()); }
+};
+
+/// @brief Locality order applied to a mesh after compaction.
+enum class MeshOrder {
+  None,
+  /// @brief Vertices and triangles sorted along a Morton curve.
+  Morton,
+  /// @brief Triangles ordered for a small LRU vertex cache (Forsyth),
+  ///        vertices in the order they are first referenced.
+  VertexCache
+};
+
+/// @brief Gather the vertices used by @param indices out of a shared pool,
+///        welding the ones with identical attributes.
+/// @param vertices Vertex pool, may be shared by several meshes.
+/// @param normals Optional normal pool, parallel to vertices.
+/// @param uvs Optional uv pool, parallel to vertices.
+/// @param indices Indices into the pool, three for each triangle.
+/// @param n_indices Number of indices.
+/// @param mesh Store the compacted mesh. Previous content is dropped.
+void compact_mesh(const Point3f *vertices, const Normal3f *normals,
+                  const Point2f *uvs, const int *indices, int n_indices,
+                  MeshData *mesh);
+/// @brief Strip unused vertices and weld duplicates in place.
+void compact_mesh(MeshData *mesh);
+/// @brief Reorder vertices and triangles for traversal locality.
+///        The geometry is left unchanged.
+void reorder_mesh(MeshData *mesh, MeshOrder order);
+}  // namespace TRay
\ No newline at end of file
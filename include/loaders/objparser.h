@@ -0,0 +1,55 @@
+/**
+ * @file objparser.h
+ * @brief Multithreaded reader for the geometry of Wavefront OBJ files.
+ *
+ * The file is mapped and split into chunks on line boundaries. A first pass
+ * counts the records of each chunk, which sizes the output arrays and gives
+ * every chunk its base offsets. A second pass parses the chunks in parallel
+ * straight into their slice of the output. Negative indices are resolved
+ * with the global counts.
+ *
+ * Only v, vn, vt, f, g and o records are read. Polygons are triangulated
+ * like tinyobj does: quads are split along the shorter diagonal, larger
+ * polygons as a fan. Materials are ignored.
+ */
+#pragma once
+#include <string>
+#include <vector>
+
+#include "core/TRay.h"
+#include "core/geometry/Normal.h"
+#include "core/geometry/Point.h"
+
+namespace TRay {
+/// @brief A run of consecutive triangles started by a g or o record.
+struct ObjShape {
+  std::string name;
+  size_t first_triangle;
+  size_t n_triangles;
+};
+
+struct ObjData {
+  std::vector<Point3f> vertices;
+  std::vector<Normal3f> normals;
+  std::vector<Point2f> uvs;
+  /// @brief Three for each triangle, indexing vertices.
+  std::vector<int> vertex_indices;
+  /// @brief Empty if the file has no normals, else parallel to
+  ///        vertex_indices with -1 for corners without one.
+  std::vector<int> normal_indices;
+  /// @brief Empty if the file has no uvs, else parallel to vertex_indices
+  ///        with -1 for corners without one.
+  std::vector<int> uv_indices;
+  /// @brief Shapes without triangles are dropped.
+  std::vector<ObjShape> shapes;
+
+  size_t n_triangles() const { return vertex_indices.size() / 3; }
+};
+
+/// @brief Read the geometry of @param filename.
+/// @param n_threads Number of threads, 0 for one per hardware thread. One
+///        inside a parallel_for.
+/// @param error Set to the reason of a failure.
+bool parse_obj(const char *filename, ObjData *obj, std::string *error,
+               int n_threads = 0);
+}  // namespace TRay
\ No newline at end of file
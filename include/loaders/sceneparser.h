@@ -0,0 +1,43 @@
+/**
+ * @file sceneparser.h
+ * @brief Streaming parser of scene files.
+ *
+ * Inline meshes can hold millions of vertices, which as DOM nodes take many
+ * times the size of the mesh. The parser drives nlohmann's SAX interface
+ * and builds the DOM for everything but the shapes[i].vertex and
+ * shapes[i].index arrays. Those are counted in the first pass and, when
+ * needed, written straight into buffers of the final size in a second one.
+ *
+ * The first pass also hashes the content that defines the world, i.e.
+ * everything but the camera, sampler, integrator and snapshot entries.
+ */
+#pragma once
+#include <nlohmann/json_fwd.hpp>
+#include <string>
+#include <vector>
+
+#include "core/TRay.h"
+#include "loaders/meshprocessing.h"
+
+namespace TRay {
+class SceneFileParser {
+ public:
+  /// @brief First pass over the scene file at @param path.
+  /// @param scene The DOM. Diverted arrays are left as null.
+  /// @param error Set to the reason of a failure.
+  bool parse(const std::string &path, nlohmann::json *scene,
+             std::string *error);
+  /// @brief Hash of the world content of the file.
+  uint64_t world_hash() const { return m_world_hash; }
+  /// @brief Second pass, reading the diverted arrays.
+  /// @param meshes One entry for each element of the shapes array, holding
+  ///        its vertices and indices. Empty for shapes without them.
+  bool read_inline_meshes(std::vector<MeshData> *meshes, std::string *error);
+
+ private:
+  std::string m_path;
+  uint64_t m_world_hash = 0;
+  /// @brief Vertex and index count for each shape.
+  std::vector<std::pair<size_t, size_t>> m_counts;
+};
+}  // namespace TRay
\ No newline at end of file
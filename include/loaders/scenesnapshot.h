@@ -0,0 +1,60 @@
+/**
+ * @file scenesnapshot.h
+ * @brief Flattened meshes of a whole scene, written next to the scene file
+ *        and memory mapped by later runs of the same world.
+ *
+ * A snapshot is keyed by the world content of the scene file, see
+ * sceneparser.h, and by the identity of every file it references. Changing
+ * the camera, sampler or integrator keeps it valid.
+ *
+ * Layout, all in native byte order:
+ *   SceneSnapshotHeader
+ *   uint32_t owner[n_shapes], index in the shapes array of each mesh
+ *   MeshCacheShape[n_shapes] at table_offset, then the arrays, as in
+ *   meshcache.h
+ */
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "core/TRay.h"
+#include "loaders/meshcache.h"
+
+namespace TRay {
+struct SceneSnapshotHeader {
+  char magic[4];
+  uint32_t version;
+  uint32_t float_size;
+  uint32_t n_shapes;
+  uint64_t key;
+  uint64_t table_offset;
+};
+
+class SceneSnapshot : public MeshBlocks {
+ public:
+  /// @brief Where the snapshot of @param scene_path lives.
+  static std::string snapshot_path(const std::string &scene_path);
+  /// @brief Key of a world with content hash @param world_hash referencing
+  ///        @param files.
+  static uint64_t key(uint64_t world_hash,
+                      const std::vector<std::string> &files);
+  /// @brief Map the snapshot of @param scene_path if it was written with
+  ///        @param key.
+  bool open(const std::string &scene_path, uint64_t key);
+  bool is_open() const { return m_file.data() != nullptr; }
+  void close();
+  /// @brief Index in the shapes array of the scene of mesh @param i.
+  uint32_t owner(int i) const { return m_owners[i]; }
+
+  /// @brief Write @param meshes, belonging to the shapes @param owners, as
+  ///        the snapshot of @param scene_path.
+  static bool write(const std::string &scene_path, uint64_t key,
+                    const std::vector<uint32_t> &owners,
+                    const std::vector<MeshData> &meshes);
+
+ private:
+  MappedFile m_file;
+  const uint32_t *m_owners = nullptr;
+};
+}  // namespace TRay
\ No newline at end of file
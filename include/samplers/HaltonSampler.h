@@ -1,13 +1,15 @@
 #pragma once
 #include "core/TRay.h"
 #include "core/Sampler.h"
+#include "core/math/lowdiscrepancy.h"
 
 namespace TRay {
-class HaltonSampler : public GlobalSampler {
+class HaltonSampler final : public GlobalSampler {
  public:
   /// @param spp Sample per pixel.
   /// @param sample_bound Bound to be sampled, Film::sample_bound().
-  HaltonSampler(int spp, const Bound2i &sample_bound);
+  /// @param scramble Permute the digits of dimensions after the first 2.
+  HaltonSampler(int spp, const Bound2i &sample_bound, bool scramble = false);
   int64_t global_index(int64_t local_index) const override;
   Float value_by_dimension(int64_t global_idx_sample,
                                    int idx_dim) const override;
@@ -22,6 +24,11 @@ class HaltonSampler : public GlobalSampler {
   Point2i m_mult_inv;
   // Each position will be visited in this frequency.
   int m_sample_stride;
+  // Terms of the first global index of pixel coordinates (mod
+  // MAX_RESOLUTION), summed up mod m_sample_stride.
+  int64_t m_pixel_offsets[2][MAX_RESOLUTION];
+  // Shared by the clones, null if not scrambled.
+  std::shared_ptr<const DigitPermutations> m_permutations;
   // 
   mutable Point2i m_offset_pixel =
       Point2i(std::numeric_limits<int>::max(), std::numeric_limits<int>::max());
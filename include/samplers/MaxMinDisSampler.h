@@ -1,25 +1,31 @@
 #pragma once
-#include "core/Sampler.h"
 #include "core/math/lowdiscrepancy.h"
+#include "samplers/ZeroTwoSampler.h"
 
 namespace TRay {
-class MaxMinDisSampler : public PixelSampler {
+/// @brief Maximized minimum distance points for the point on film, the
+///        samples of ZeroTwoSampler for the others.
+class MaxMinDisSampler final : public ZeroTwoSampler {
  public:
-  MaxMinDisSampler(int64_t spp, int n_dims) : PixelSampler(round(spp), n_dims) {
+  MaxMinDisSampler(int64_t spp, int n_dims) : ZeroTwoSampler(spp, n_dims) {
     // SInfo(string_format(
     //     "MaxMinSampler:: Created max-minimum distance sampler with"
     //     "\n\tspp %d rounded up to %d"
     //     "\n\tsample dimensions %d",
     //     spp, round(spp), n_dims));
-    //     m_C = CMaxMinDis[log2_int(spp)];
+    // Matrices are tabulated up to 2^16 spp.
+    int expo = log2_int(uint32_t(m_spp));
+    ASSERT(expo <= 16);
+    m_C = CMaxMinDis[expo];
   }
-  void start_pixel(const Point2i &p) override;
   std::unique_ptr<Sampler> clone(int seed) const override {
     MaxMinDisSampler *sampler = new MaxMinDisSampler(*this);
     sampler->m_rng.set_sequence(seed);
     return std::unique_ptr<Sampler>(sampler);
   }
-  int round(int n) override { return pow2_ceil(n); }
+
+ protected:
+  void fill_2D(int dim) override;
 
  private:
   const uint32_t *m_C;
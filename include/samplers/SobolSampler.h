@@ -1,9 +1,10 @@
 #pragma once
 #include "core/Sampler.h"
 #include "core/TRay.h"
+#include "core/math/lowdiscrepancy.h"
 
 namespace TRay {
-class SobolSampler : public GlobalSampler {
+class SobolSampler final : public GlobalSampler {
  public:
   SobolSampler(int64_t spp, const Bound2i &sample_bound)
       : GlobalSampler(round(spp)), m_sample_bound(sample_bound) {
@@ -11,6 +12,11 @@ class SobolSampler : public GlobalSampler {
     m_scale = pow2_ceil(
         std::max(sample_bound.diagonal().x, sample_bound.diagonal().y));
     m_scale_expo = log2_int(m_scale);
+    // The global index is linear in the local one, plus the pixel's offset.
+    // Going to local index j flips bits [0, ctz(j)] of it.
+    for (int t = 0; t < 32; t++)
+      m_index_step[t] = global_index_Sobol(m_scale_expo, (2ull << t) - 1,
+                                           Point2i(0, 0));
     // SInfo(
     //     string_format("SobolSampler:: Created Sobol' sampler with"
     //                   "\n\tspp %d rounded up to %d"
@@ -20,6 +26,10 @@ class SobolSampler : public GlobalSampler {
   int64_t global_index(int64_t local_index) const override;
   Float value_by_dimension(int64_t global_idx_sample,
                            int idx_dim) const override;
+  void values_by_dimension(int64_t global_idx_sample, int idx_dim, int n,
+                           Float *values) const override;
+  int64_t next_global_index(int64_t global_idx,
+                            int64_t local_index) const override;
   std::unique_ptr<Sampler> clone(int) const override {
     return std::unique_ptr<Sampler>(new SobolSampler(*this));
   }
@@ -28,5 +38,7 @@ class SobolSampler : public GlobalSampler {
  private:
   const Bound2i m_sample_bound;
   int m_scale, m_scale_expo;
+  // Global index difference when stepping to local index j, by ctz(j).
+  uint64_t m_index_step[32];
 };
 }  // namespace TRay
\ No newline at end of file
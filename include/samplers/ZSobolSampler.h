@@ -0,0 +1,50 @@
+#pragma once
+#include "core/Sampler.h"
+#include "core/TRay.h"
+
+namespace TRay {
+/// @brief Sobol' samples indexed by the Morton code of the pixel, each pixel
+///        takes spp consecutive samples of one sequence. Base 4 digits of the
+///        index are shuffled by hashes of the higher digits and the
+///        dimension, and the values are Owen scrambled. Errors of
+///        neighbouring pixels spread out like blue noise, no matrix is
+///        inverted and any resolution works.
+/// @see Ahmed and Wonka, Screen-Space Blue-Noise Diffusion of Monte Carlo
+///      Sampling Error via Hierarchical Ordering of Pixels, 2020.
+class ZSobolSampler final : public GlobalSampler {
+ public:
+  /// @param spp Sample per pixel, rounded up to a power of 2.
+  /// @param sample_bound Bound to be sampled, Film::sample_bound().
+  /// @param seed Seed of the shuffles and scrambles.
+  ZSobolSampler(int64_t spp, const Bound2i &sample_bound, uint32_t seed = 0);
+  /// @brief Widen the pixels' index ranges to hold the requested arrays.
+  void start_pixel(const Point2i &p) override;
+  /// @return Morton index of the sample, the pixel's Morton code followed by
+  ///         the local index.
+  int64_t global_index(int64_t local_index) const override;
+  Float value_by_dimension(int64_t global_idx_sample,
+                           int idx_dim) const override;
+  /// @brief Two dimensions are taken from a single 2D Sobol' sample.
+  void values_by_dimension(int64_t global_idx_sample, int idx_dim, int n,
+                           Float *values) const override;
+  std::unique_ptr<Sampler> clone(int) const override {
+    return std::unique_ptr<Sampler>(new ZSobolSampler(*this));
+  }
+  int round(int n) override { return pow2_ceil(n); }
+
+ private:
+  /// @brief Index into the Sobol' sequence of Morton index @param morton_idx
+  ///        for dimension @param idx_dim.
+  uint64_t sample_index(uint64_t morton_idx, int idx_dim) const;
+  /// @brief Give each pixel 2^@param log2_samples local indices.
+  void set_log2_samples(int log2_samples);
+
+  const Bound2i m_sample_bound;
+  int m_log2_spp, m_log2_res;
+  // Local indices of a pixel, spp times the largest array size.
+  int m_log2_samples;
+  // Base 4 digits of Morton indices, the last one may be a single bit.
+  int m_n_base4_digits;
+  uint32_t m_seed;
+};
+}  // namespace TRay
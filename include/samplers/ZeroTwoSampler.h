@@ -1,6 +1,7 @@
 #pragma once
 #include "core/Sampler.h"
 #include "core/TRay.h"
+#include "core/math/lowdiscrepancy.h"
 
 
 namespace TRay {
@@ -8,7 +9,9 @@ namespace TRay {
 /// van der Corput sequence for 1D samples.
 class ZeroTwoSampler : public PixelSampler {
  public:
-  ZeroTwoSampler(int64_t spp, int n_dims) : PixelSampler(round(spp), n_dims) {
+  ZeroTwoSampler(int64_t spp, int n_dims)
+      : PixelSampler(round(spp), n_dims),
+        m_table(std::make_shared<const ZeroTwoTable>(m_spp)) {
     // SInfo(
     //     string_format("ZeroTwoSampler:: Created (0-2)-sequence sampler with"
     //                   "\n\tspp %d rounded up to %d"
@@ -16,12 +19,21 @@ class ZeroTwoSampler : public PixelSampler {
     //                   spp, round(spp), n_dims));
   }
 
-  void start_pixel(const Point2i &p) override;
   std::unique_ptr<Sampler> clone(int seed) const override {
     ZeroTwoSampler *sampler = new ZeroTwoSampler(*this);
     sampler->m_rng.set_sequence(seed);
     return std::unique_ptr<Sampler>(sampler);
   }
   int round(int n) override { return pow2_ceil(n); }
+  void reserve_dimensions(const SampleDimensions &dims) override;
+
+ protected:
+  void fill_arrays() override;
+  void fill_1D(int dim) override;
+  void fill_2D(int dim) override;
+
+ private:
+  // Shared by the clones, grown for the arrays by reserve_dimensions().
+  std::shared_ptr<const ZeroTwoTable> m_table;
 };
 }  // namespace TRay
\ No newline at end of file
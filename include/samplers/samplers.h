@@ -4,4 +4,5 @@
 #include "samplers/HaltonSampler.h"
 #include "samplers/ZeroTwoSampler.h"
 #include "samplers/MaxMinDisSampler.h"
-#include "samplers/SobolSampler.h"
\ No newline at end of file
+#include "samplers/SobolSampler.h"
+#include "samplers/ZSobolSampler.h"
\ No newline at end of file
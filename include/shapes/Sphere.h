@@ -23,13 +23,23 @@ class Sphere : public Shape {
         theta_min(0),
         theta_max(PI),
         phi_max(deg_to_rad(360)) {
+    Vector3f translation;
+    world_space =
+        obj_to_world->is_translate_uniform_scale(&translation, &world_scale);
+    if (world_space) {
+      world_center = Point3f(0, 0, 0) + translation;
+      world_radius = radius * world_scale;
+    }
     SInfo("Sphere:: Created sphere with" +
           string_format("\n\tradius %f", radius) + "\n\tworld coord " +
           (*obj_to_world)(Point3f(0, 0, 0)).to_string());
   }
   Bound3f object_bound() const override;
+  Bound3f world_bound() const override;
   bool intersect(const Ray &ray, Float *thit, SurfaceInteraction *si,
                  bool test_alpha_texture = true) const override;
+  bool intersect_test(const Ray &ray,
+                      bool test_alpha_texture = true) const override;
   Interaction sample_surface(const Point2f &u,
                              Float *pdf_value = nullptr) const override;
   Interaction sample_surface(const Interaction &ref, const Point2f &u,
@@ -59,9 +69,19 @@ class Sphere : public Shape {
   //       phi_max(deg_to_rad(clamp(p_max, 0, 360))) {}
 
  private:
+  /// @brief Parametric distance of the first hit in (0, t_max).
+  /// @param p_obj Store the hit point in object space.
+  bool hit(const Ray &ray, Float *t_hit, Point3f *p_obj) const;
+
   const Float radius;
   const Float z_min, z_max;
   const Float theta_min, theta_max;
   const Float phi_max;
+  // Spheres only translated and uniformly scaled are intersected in world
+  // space, skipping the ray transform. Exact to the object-space path for
+  // power-of-2 scales only, see intersect().
+  bool world_space = false;
+  Point3f world_center;
+  Float world_radius = 0, world_scale = 1;
 };
 }  // namespace TRay
\ No newline at end of file
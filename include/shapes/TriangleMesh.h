@@ -1,6 +1,7 @@
 #pragma once
 #include "core/TRay.h"
 #include "core/geometry/Shape.h"
+#include "core/statistics.h"
 
 namespace TRay {
 /// @brief Just what you think it is.
@@ -11,6 +12,7 @@ struct TriangleMesh {
   /// @param n_triangles Number of triangles.
   /// @param vertex_indices Array of vertex indices, three for each triangle.
   ///                       Layout: [t0_0, t0_1, t0_2, t1_0, ...].
+  ///                       Stored in 16 bits if n_vertices allows.
   /// @param vertices Array of vertices, access from index array only.
   /// @param vertex_normals Array of vertex normals. Optional.
   /// @param vertex_uv Array of vertex uv. Optional.
@@ -19,12 +21,21 @@ struct TriangleMesh {
                const Point3f* vertices,
                const Normal3f* vertex_normals = nullptr,
                const Point2f* vertex_uv = nullptr);
+  /// @brief The @param i -th entry of the index buffer.
+  int vertex_index(int i) const {
+    return vindex16.empty() ? int(vindex32[i]) : int(vindex16[i]);
+  }
   const int n_triangles, n_vertices;
   /// @brief Vertex indices for triangles, three in a row.
-  std::vector<int> vindex;
+  ///        Only one of them is used, the 16-bit one for meshes with less than
+  ///        65536 vertices.
+  std::vector<uint16_t> vindex16;
+  std::vector<uint32_t> vindex32;
   std::unique_ptr<Point3f[]> vpos;
   std::unique_ptr<Normal3f[]> vnormal;
   std::unique_ptr<Point2f[]> vuv;
+  /// @brief Bytes of the buffers above, for memory statistics.
+  TrackedMemory memory;
 };
 
 class Triangle : public Shape {
@@ -41,9 +52,9 @@ class Triangle : public Shape {
 
   void uv_values(Point2f uv[3]) const {
     if (m_parent_mesh->vuv) {
-      uv[0] = m_parent_mesh->vuv[vidx[0]];
-      uv[1] = m_parent_mesh->vuv[vidx[1]];
-      uv[2] = m_parent_mesh->vuv[vidx[2]];
+      uv[0] = m_parent_mesh->vuv[vidx(0)];
+      uv[1] = m_parent_mesh->vuv[vidx(1)];
+      uv[2] = m_parent_mesh->vuv[vidx(2)];
     } else {
       uv[0] = Point2f(0, 0);
       uv[1] = Point2f(1, 0);
@@ -52,8 +63,14 @@ class Triangle : public Shape {
   }
 
  private:
+  /// @brief Index of the @param k -th vertex of this triangle.
+  int vidx(int k) const {
+    return m_parent_mesh->vertex_index(m_first_index + k);
+  }
+
   std::shared_ptr<TriangleMesh> m_parent_mesh;
-  const int* vidx;
+  // Offset of this triangle in the index buffer.
+  const int m_first_index;
 };
 
 std::vector<std::shared_ptr<Shape>> create_triangle_mesh(
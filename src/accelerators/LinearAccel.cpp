@@ -1,9 +1,11 @@
 #include "accelerators/LinearAccel.h"
 
 namespace TRay {
+STAT_MEMORY("Memory/accelerator", accel_memory);
 
 LinearAccel::LinearAccel(std::vector<std::shared_ptr<Primitive>> primitives)
-    : m_primitives(std::move(primitives)) {
+    : m_primitives(std::move(primitives)), m_memory(&accel_memory) {
+  m_memory.set(m_primitives.capacity() * sizeof(m_primitives[0]));
   SInfo("LinearAccel:: Created an accelerator with" +
         string_format("\n\t%d primitives.", (int)m_primitives.size()));
   for (const auto &prim : m_primitives) {
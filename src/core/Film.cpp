@@ -1,14 +1,19 @@
 #include "core/Film.h"
 
-#include "core/image.h"
+#include <cstdio>
+#include <cstring>
 
+#include "core/image.h"
 
 namespace TRay {
+STAT_MEMORY("Memory/film", film_memory);
 Film::Film(const Point2i &resolution, const Bound2f &crop_window,
            std::unique_ptr<Filter> filter, const std::string &filename)
     : m_full_resolution(resolution),
+      m_crop_window(crop_window),
       m_filter(std::move(filter)),
-      m_filename(filename) {
+      m_filename(filename),
+      m_memory(&film_memory) {
   // Calculate the actually stored image.
   m_cropped_pixel_bound =
       Bound2i(Point2i(std::ceil(m_full_resolution.x * crop_window.p_min.x),
@@ -22,6 +27,7 @@ Film::Film(const Point2i &resolution, const Bound2f &crop_window,
         string_format("\n\t%d Pixels.", m_cropped_pixel_bound.area()));
   // Allocate the pixel array.
   m_pixels = std::unique_ptr<Pixel[]>(new Pixel[m_cropped_pixel_bound.area()]);
+  m_memory.set(m_cropped_pixel_bound.area() * sizeof(Pixel));
   // Precompute filter LUT.
   int offset = 0;
   Point2f p;
@@ -33,6 +39,19 @@ Film::Film(const Point2i &resolution, const Bound2f &crop_window,
     }
   }
 }
+void Film::recrop(const Bound2i &pixel_bound) {
+  m_cropped_pixel_bound = bound_intersect(
+      pixel_bound, Bound2i(Point2i(0, 0), m_full_resolution));
+  m_crop_window = Bound2f(
+      Point2f(Float(m_cropped_pixel_bound.p_min.x) / m_full_resolution.x,
+              Float(m_cropped_pixel_bound.p_min.y) / m_full_resolution.y),
+      Point2f(Float(m_cropped_pixel_bound.p_max.x) / m_full_resolution.x,
+              Float(m_cropped_pixel_bound.p_max.y) / m_full_resolution.y));
+  m_pixels = std::unique_ptr<Pixel[]>(new Pixel[m_cropped_pixel_bound.area()]);
+  m_memory.set(m_cropped_pixel_bound.area() * sizeof(Pixel));
+  m_rows_callback = nullptr;
+  m_rows_final = 0;
+}
 Bound2i Film::sample_bound() const {
   // The 0.5 offset is to move to the center.
   Bound2f bound_float(floor(Point2f(m_cropped_pixel_bound.p_min) +
@@ -96,41 +115,162 @@ void Film::set_image(const Spectrum *colors) {
   }
 }
 void Film::write_image(Float, uint8_t *dst) {
+  write_image_rows(0, m_cropped_pixel_bound.diagonal().y, dst);
+}
+void Film::write_image_rows(int y0, int y1, uint8_t *dst) const {
   ASSERT(dst != nullptr);
-  int offset = 0;
-  const Bound2i &bound = m_cropped_pixel_bound;
-  std::unique_ptr<Float[]> rgb_arr(new Float[bound.area() * 3]);
-  Bound2iIterator pxl_range(bound);
-  for (const Point2i &pxl_pos : pxl_range) {
-    const Pixel &pxl = pixel(pxl_pos);
-    rgb_arr[offset * 3 + 0] = pxl.rgb[0];
-    rgb_arr[offset * 3 + 1] = pxl.rgb[1];
-    rgb_arr[offset * 3 + 2] = pxl.rgb[2];
+  // Pixels are stored in the same order as written, convert them in place.
+  int width = m_cropped_pixel_bound.diagonal().x;
+  dst += size_t(y0) * width * 3;
+  for (int i = y0 * width; i < y1 * width; i++) {
+    const Pixel &pxl = m_pixels[i];
+    Float rgb[3] = {pxl.rgb[0], pxl.rgb[1], pxl.rgb[2]};
     if (pxl.filter_weight_sum) {
       Float w_inv = 1.0 / pxl.filter_weight_sum;
-      rgb_arr[offset * 3 + 0] =
-          std::max(Float(0), rgb_arr[offset * 3 + 0] * w_inv);
-      rgb_arr[offset * 3 + 1] =
-          std::max(Float(0), rgb_arr[offset * 3 + 1] * w_inv);
-      rgb_arr[offset * 3 + 2] =
-          std::max(Float(0), rgb_arr[offset * 3 + 2] * w_inv);
+      for (int c = 0; c < 3; c++) rgb[c] = std::max(Float(0), rgb[c] * w_inv);
     }
-    offset++;
-  }
-  // image_to_array(&rgb_arr[0], dst, bound.diagonal().x, bound.diagonal().y);
-  Float *src = &rgb_arr[0];
-  int width = bound.diagonal().x, height = bound.diagonal().y;
-  for (int y = 0; y < height; y++) {
-    for (int x = 0; x < width; x++) {
 // Gamma correction and scale to [0, 255].
 #define uint8RGB(v) (uint8_t) clamp(255.0 * gamma_correct(v) + 0.5, 0.0, 255.0)
-      dst[0] = uint8RGB(src[(y * width + x) * 3 + 0]);
-      dst[1] = uint8RGB(src[(y * width + x) * 3 + 1]);
-      dst[2] = uint8RGB(src[(y * width + x) * 3 + 2]);
+    dst[0] = uint8RGB(rgb[0]);
+    dst[1] = uint8RGB(rgb[1]);
+    dst[2] = uint8RGB(rgb[2]);
 #undef uint8RGB
-      dst += 3;
+    dst += 3;
+  }
+}
+void Film::set_rows_callback(RowsCallback callback) {
+  m_rows_callback = std::move(callback);
+  m_rows_final = 0;
+}
+void Film::samples_merged_below(int y) {
+  if (!m_rows_callback) return;
+  int height = m_cropped_pixel_bound.diagonal().y;
+  // Later samples reach down to the first pixel get_tile gives them.
+  int rows = height;
+  if (y < sample_bound().p_max.y)
+    rows = int(std::ceil(y - 0.5 - m_filter->m_radius.y)) -
+           m_cropped_pixel_bound.p_min.y;
+  rows = std::min(rows, height);
+  if (rows <= m_rows_final) return;
+  m_rows_callback(m_rows_final, rows);
+  m_rows_final = rows;
+}
+bool Film::write_pfm(const std::string &filename) {
+  int width = m_cropped_pixel_bound.diagonal().x;
+  int height = m_cropped_pixel_bound.diagonal().y;
+  FILE *f = fopen(filename.c_str(), "wb");
+  if (!f) {
+    SError("Film::write_pfm: Failed to open " + filename);
+    return false;
+  }
+  // Negative scale for little endian data, as written by the supported
+  // hosts. PFM rows go from bottom to top.
+  fprintf(f, "PF\n%d %d\n-1.0\n", width, height);
+  std::vector<float> row(size_t(width) * 3);
+  bool ok = true;
+  for (int y = height - 1; y >= 0 && ok; y--) {
+    const Pixel *pxl = &m_pixels[size_t(y) * width];
+    for (int x = 0; x < width; x++, pxl++) {
+      // Unlike write_image, negative values from the filter are kept.
+      Float w_inv = pxl->filter_weight_sum ? 1.0 / pxl->filter_weight_sum : 1;
+      for (int c = 0; c < 3; c++) row[x * 3 + c] = float(pxl->rgb[c] * w_inv);
+    }
+    ok = fwrite(row.data(), sizeof(float), row.size(), f) == row.size();
+  }
+  ok = fclose(f) == 0 && ok;
+  if (!ok) SError("Film::write_pfm: Failed to write " + filename);
+  return ok;
+}
+static const char kPartialFilmMagic[4] = {'T', 'R', 'P', 'F'};
+static constexpr uint32_t kPartialFilmVersion = 1;
+
+bool Film::write_partial(const std::string &filename, int part,
+                         int n_parts) const {
+  PartialFilmHeader header;
+  memcpy(header.magic, kPartialFilmMagic, 4);
+  header.version = kPartialFilmVersion;
+  header.float_size = sizeof(Float);
+  header.part = part;
+  header.n_parts = n_parts;
+  header.resolution[0] = m_full_resolution.x;
+  header.resolution[1] = m_full_resolution.y;
+  header.crop_window[0] = m_crop_window.p_min.x;
+  header.crop_window[1] = m_crop_window.p_min.y;
+  header.crop_window[2] = m_crop_window.p_max.x;
+  header.crop_window[3] = m_crop_window.p_max.y;
+  FILE *f = fopen(filename.c_str(), "wb");
+  if (!f) {
+    SError("Film::write_partial: Failed to open " + filename);
+    return false;
+  }
+  size_t n_pixels = m_cropped_pixel_bound.area();
+  bool ok = fwrite(&header, sizeof(header), 1, f) == 1 &&
+            fwrite(m_pixels.get(), sizeof(Pixel), n_pixels, f) == n_pixels;
+  ok = fclose(f) == 0 && ok;
+  if (!ok) SError("Film::write_partial: Failed to write " + filename);
+  return ok;
+}
+/// @brief Read and check the header, leaves @param f at the pixels.
+static bool read_partial_header(FILE *f, const std::string &filename,
+                                PartialFilmHeader *header) {
+  if (fread(header, sizeof(*header), 1, f) != 1 ||
+      memcmp(header->magic, kPartialFilmMagic, 4) != 0 ||
+      header->version != kPartialFilmVersion) {
+    SError("Film:: Not a partial film, " + filename);
+    return false;
+  }
+  if (header->float_size != sizeof(Float)) {
+    SError("Film:: Partial film written with another Float, " + filename);
+    return false;
+  }
+  return true;
+}
+bool Film::read_partial_header(const std::string &filename,
+                               PartialFilmHeader *header) {
+  FILE *f = fopen(filename.c_str(), "rb");
+  if (!f) {
+    SError("Film::read_partial_header: Failed to open " + filename);
+    return false;
+  }
+  bool ok = TRay::read_partial_header(f, filename, header);
+  fclose(f);
+  return ok;
+}
+bool Film::add_partial(const std::string &filename,
+                       PartialFilmHeader *header) {
+  FILE *f = fopen(filename.c_str(), "rb");
+  if (!f) {
+    SError("Film::add_partial: Failed to open " + filename);
+    return false;
+  }
+  bool ok = TRay::read_partial_header(f, filename, header);
+  if (ok && (header->resolution[0] != m_full_resolution.x ||
+             header->resolution[1] != m_full_resolution.y ||
+             header->crop_window[0] != m_crop_window.p_min.x ||
+             header->crop_window[1] != m_crop_window.p_min.y ||
+             header->crop_window[2] != m_crop_window.p_max.x ||
+             header->crop_window[3] != m_crop_window.p_max.y)) {
+    SError("Film::add_partial: " + filename + " is another image");
+    ok = false;
+  }
+  // Sum one row at a time.
+  int width = m_cropped_pixel_bound.diagonal().x;
+  int height = m_cropped_pixel_bound.diagonal().y;
+  std::vector<Pixel> row(width);
+  for (int y = 0; y < height && ok; y++) {
+    if (fread(row.data(), sizeof(Pixel), width, f) != size_t(width)) {
+      SError("Film::add_partial: Truncated " + filename);
+      ok = false;
+      break;
+    }
+    Pixel *dst = &m_pixels[size_t(y) * width];
+    for (int x = 0; x < width; x++) {
+      for (int c = 0; c < 3; c++) dst[x].rgb[c] += row[x].rgb[c];
+      dst[x].filter_weight_sum += row[x].filter_weight_sum;
     }
   }
+  fclose(f);
+  return ok;
 }
 
 void FilmTile::add_sample(const Point2f &point_film, const Spectrum &L,
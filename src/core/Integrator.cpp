@@ -16,7 +16,8 @@ STAT_COUNTER("Integrator/ray_sample", ray_sample_counter);
 namespace TRay {
 void SamplerIntegrator::render(const Scene &scene) {
   SInfo("SamplerIntegrator::render: Start rendering.");
-  preprocess(scene, *m_sampler);
+  prepare(scene);
+  m_validator->reset(m_camera->m_film->m_cropped_pixel_bound);
   // Render.
   // -------
   // Number of tiles.
@@ -28,6 +29,9 @@ void SamplerIntegrator::render(const Scene &scene) {
                   (sample_extent.y + tile_size - 1) / tile_size);
   SInfo("SampleIntegrator::render:\n\tSample bound: " +
         sample_bound.to_string());
+  // Sample indices of this part, see set_sample_part.
+  int64_t sample_begin = m_sampler->m_spp * m_sample_part / m_sample_parts;
+  int64_t sample_end = m_sampler->m_spp * (m_sample_part + 1) / m_sample_parts;
   // Iteration.
   /**
    * For every tile:
@@ -45,7 +49,10 @@ void SamplerIntegrator::render(const Scene &scene) {
     // Memory allocation.
     // TODO MemoryPool
     // Sample instance for this tile.
-    int sample_seed = tile.y * n_tiles.x + tile.x;
+    // Parts draw from their own seeds, samplers that ignore the seed tell
+    // them apart by the sample indices.
+    int sample_seed =
+        tile.y * n_tiles.x + tile.x + m_sample_part * n_tiles.x * n_tiles.y;
     std::unique_ptr<Sampler> tile_sampler = m_sampler->clone(sample_seed);
     // Bound for this tile.
     int x0 = sample_bound.p_min.x + tile.x * tile_size;
@@ -63,6 +70,9 @@ void SamplerIntegrator::render(const Scene &scene) {
     for (const Point2i &pxl : bound_range) {
       // Begin for this pixel.
       tile_sampler->start_pixel(pxl);
+      if (sample_begin >= sample_end ||
+          !tile_sampler->set_sample_index(sample_begin))
+        continue;
       do {
         // Get a camera sample.
         CameraSample cam_sample = tile_sampler->camera_sample(pxl);
@@ -75,39 +85,36 @@ void SamplerIntegrator::render(const Scene &scene) {
         if (ray_w > 0)
           L = Li(ray, scene, *tile_sampler);
         // Check.
-        if (L.has_NaN()) {
-          SError(string_format(
-              "Get NaN radiance value "
-              "for pixel (%d, %d), sample %d. Black value is used.",
-              pxl.x, pxl.y, (int)tile_sampler->current_sample_index()));
-          L = Spectrum(0.f);
-        } else if (L.y() < -1e-5) {
-          SError(string_format(
-              "Get negative radiance value, %f "
-              "for pixel (%d, %d), sample %d. Black value is used.",
-              L.y(), pxl.x, pxl.y, (int)tile_sampler->current_sample_index()));
-          L = Spectrum(0.f);
-        } else if (std::isinf(L.y())) {
-          SError(string_format(
-              "Get INF radiance value "
-              "for pixel (%d, %d), sample %d. Black value is used.",
-              pxl.x, pxl.y, (int)tile_sampler->current_sample_index()));
-          L = Spectrum(0.f);
-        }
+        m_validator->validate(&L, pxl, tile_sampler->current_sample_index());
         film_tile->add_sample(cam_sample.m_point_film, L, ray_w);
-      } while (tile_sampler->next_sample());
+      } while (tile_sampler->next_sample() &&
+               tile_sampler->current_sample_index() < sample_end);
     }
     m_camera->m_film->merge_tile(std::move(film_tile));
   };
+  // Tiles already merged into the film by an earlier, interrupted run.
+  std::vector<uint8_t> tile_done(n_tiles.x * n_tiles.y, 0);
+  if (m_checkpoint) m_checkpoint->resume(m_camera->m_film.get(), &tile_done);
   // No parallelism by now.
-  for (int y = 0; y < n_tiles.y; ++y)
+  for (int y = 0; y < n_tiles.y; ++y) {
     for (int x = 0; x < n_tiles.x; ++x) {
       tile_cnt++;
+      int tile_index = y * n_tiles.x + x;
+      if (tile_done[tile_index]) continue;
       per_tile(Point2i(x, y));
+      tile_done[tile_index] = 1;
+      if (m_checkpoint) m_checkpoint->tile_done(*m_camera->m_film, tile_done);
     }
+    // Let the output convert the rows this tile row finished.
+    m_camera->m_film->samples_merged_below(
+        std::min(sample_bound.p_min.y + (y + 1) * tile_size,
+                 sample_bound.p_max.y));
+  }
+  if (m_checkpoint) m_checkpoint->finish();
   // Write to file.
   // --------------
   SInfo("SamplerIntegrator::render: Done rendering.");
+  m_validator->report();
   ReportThreadStats();
 }
 /**
@@ -132,7 +139,8 @@ void SamplerIntegrator::render(const Scene &scene) {
 bool SamplerIntegrator::render_step(const Scene &scene) {
   if (m_tiles.empty()) {
     SInfo("SamplerIntegrator::render_step: Empty tile list, preprocessing.");
-    preprocess(scene, *m_sampler);
+    prepare(scene);
+    m_validator->reset(m_camera->m_film->m_cropped_pixel_bound);
 
     // Number of tiles.
     Bound2i sample_bound = m_camera->m_film->sample_bound();
@@ -173,6 +181,17 @@ bool SamplerIntegrator::render_step(const Scene &scene) {
   }
 }
 /***************************************************/
+void SamplerIntegrator::prepare(const Scene &scene) {
+  preprocess(scene, *m_sampler);
+  SampleDimensions dims = sample_dimensions(scene);
+  // See Sampler::camera_sample().
+  dims.n_1D += 1;
+  dims.n_2D += 2;
+  m_sampler->reserve_dimensions(dims);
+  SInfo(string_format("SamplerIntegrator::prepare: %d 1D and %d 2D dimensions "
+                      "per sample",
+                      dims.n_1D, dims.n_2D));
+}
 Spectrum SamplerIntegrator::specular_reflect(const Ray &ray,
                                              const SurfaceInteraction &si,
                                              const Scene &scene,
@@ -7,6 +7,7 @@
 namespace TRay {
 STAT_COUNTER("MemoryPool/aligned_alloc_call", alloc_counter);
 STAT_COUNTER("MemoryPool/aligned_alloc_byte", alloc_size);
+STAT_MEMORY("Memory/memory_pool", pool_memory);
 void *allocAligned(size_t size) {
   alloc_counter++;
   alloc_size += size;
@@ -25,6 +26,8 @@ void freeAligned(void *ptr) {
 #endif
 }
 
+MemoryPool::MemoryPool(size_t block_size)
+    : kMinBlockSize_(block_size), memory_(&pool_memory) {}
 MemoryPool::~MemoryPool() {
   freeAligned(current_block_);
   for (auto &block : used_blocks_) freeAligned(block.second);
@@ -55,6 +58,7 @@ void *MemoryPool::alloc(size_t n_bytes) {
     if (!current_block_) {
       current_block_size_ = std::max(n_bytes, kMinBlockSize_);
       current_block_ = allocAligned<uint8_t>(current_block_size_);
+      memory_.add(current_block_size_);
     }
     current_block_pos_ = 0;
   }
@@ -1,9 +1,13 @@
 #include "core/Sampler.h"
 
 #include "core/Camera.h"
+#include "core/math/bluenoise.h"
 
 namespace TRay {
-Sampler::Sampler(int64_t sample_per_pixel) : m_spp(sample_per_pixel) {
+STAT_MEMORY("Memory/sampler", sampler_memory);
+STAT_COUNTER("Sampler/dimensions_extended", dimensions_extended);
+Sampler::Sampler(int64_t sample_per_pixel)
+    : m_spp(sample_per_pixel), m_memory(&sampler_memory) {
   // SInfo("Sampler:: Created sampler with" +
   //       string_format("\n\tspp %llu", sample_per_pixel));
 }
@@ -18,6 +22,21 @@ CameraSample Sampler::camera_sample(const Point2i &p) {
   cs.m_point_lens = sample_2D();
   return cs;
 }
+Float Sampler::dither(Float u, int dim) const {
+  u += m_blue_noise->value(m_current_pixel, dim);
+  if (u >= 1) u -= 1;
+  return std::min(u, ONE_M_EPS);
+}
+void Sampler::dither_arrays() {
+  // Mask dimensions apart from those of the sample vectors.
+  const int first_dim = 4096;
+  for (size_t i = 0; i < m_sample_1D_array.size(); i++)
+    for (Float &u : m_sample_1D_array[i]) u = dither(u, first_dim + 3 * i);
+  for (size_t i = 0; i < m_sample_2D_array.size(); i++)
+    for (Point2f &u : m_sample_2D_array[i])
+      u = Point2f(dither(u.x, first_dim + 3 * i + 1),
+                  dither(u.y, first_dim + 3 * i + 2));
+}
 void Sampler::start_pixel(const Point2i &p) {
   // Change the current pixel and sample index.
   m_current_pixel = p;
@@ -42,11 +61,13 @@ void Sampler::request_1D_array(int n) {
   // Note the layout: first n values is for each sample.
   // In splitting of MCM this means how many sub-samples?
   m_sample_1D_array.push_back(std::vector<Float>(n * m_spp));
+  m_memory.add(n * m_spp * sizeof(Float));
 }
 void Sampler::request_2D_array(int n) {
   ASSERT(n == round(n));
   m_2D_array_sizes.push_back(n);
   m_sample_2D_array.push_back(std::vector<Point2f>(n * m_spp));
+  m_memory.add(n * m_spp * sizeof(Point2f));
 }
 const Float *Sampler::get_1D_array(int n) {
   if (m_1D_array_offset >= m_1D_array_sizes.size()) return nullptr;
@@ -67,9 +88,51 @@ PixelSampler::PixelSampler(int64_t samples_per_pxiel, int sample_dims)
     : Sampler(samples_per_pxiel) {
   // SInfo("PixelSampler:: Created pixel sampler with" +
   //       string_format("\n\tsample dims %d", sample_dims));
-  for (int i = 0; i < sample_dims; i++) {
+  add_dimensions(sample_dims, sample_dims);
+}
+void PixelSampler::add_dimensions(int n_1D, int n_2D) {
+  n_1D = std::min(n_1D, MaxDimensions);
+  n_2D = std::min(n_2D, MaxDimensions);
+  while (m_sample_1D.size() < size_t(n_1D)) {
     m_sample_1D.push_back(std::vector<Float>(m_spp));
+    m_memory.add(m_spp * sizeof(Float));
+  }
+  while (m_sample_2D.size() < size_t(n_2D)) {
     m_sample_2D.push_back(std::vector<Point2f>(m_spp));
+    m_memory.add(m_spp * sizeof(Point2f));
+  }
+}
+void PixelSampler::reserve_dimensions(const SampleDimensions &dims) {
+  add_dimensions(dims.n_1D, dims.n_2D);
+}
+void PixelSampler::start_pixel(const Point2i &p) {
+  m_n_filled_1D = m_n_filled_2D = 0;
+  // Dithered pixels share one set of values, the arrays and dimensions are
+  // filled in the same order from the same stream.
+  if (m_blue_noise) m_rng.set_sequence(0);
+  Sampler::start_pixel(p);
+  fill_arrays();
+  if (m_blue_noise) dither_arrays();
+}
+void PixelSampler::fill_arrays() {
+  for (std::vector<Float> &array : m_sample_1D_array)
+    for (Float &u : array) u = std::min(m_rng.uniform_float(), ONE_M_EPS);
+  for (std::vector<Point2f> &array : m_sample_2D_array)
+    for (Point2f &u : array) {
+      Float x = std::min(m_rng.uniform_float(), ONE_M_EPS);
+      Float y = std::min(m_rng.uniform_float(), ONE_M_EPS);
+      u = Point2f(x, y);
+    }
+}
+void PixelSampler::fill_1D(int dim) {
+  for (int64_t i = 0; i < m_spp; i++)
+    m_sample_1D[dim][i] = std::min(m_rng.uniform_float(), ONE_M_EPS);
+}
+void PixelSampler::fill_2D(int dim) {
+  for (int64_t i = 0; i < m_spp; i++) {
+    Float x = std::min(m_rng.uniform_float(), ONE_M_EPS);
+    Float y = std::min(m_rng.uniform_float(), ONE_M_EPS);
+    m_sample_2D[dim][i] = Point2f(x, y);
   }
 }
 bool PixelSampler::next_sample() {
@@ -82,8 +145,18 @@ bool PixelSampler::set_sample_index(int64_t idx) {
 }
 
 Float PixelSampler::sample_1D() {
+  // Deeper than expected, the tables stay extended for later pixels.
+  if ((size_t)m_idx_current_1D == m_sample_1D.size() &&
+      m_idx_current_1D < MaxDimensions) {
+    add_dimensions(m_idx_current_1D + 1, 0);
+    dimensions_extended++;
+  }
   if ((size_t)m_idx_current_1D < m_sample_1D.size()) {
-    return m_sample_1D[m_idx_current_1D++][m_idx_current_pixel_sample];
+    if (m_idx_current_1D == m_n_filled_1D) fill_1D(m_n_filled_1D++);
+    int dim = m_idx_current_1D++;
+    Float u = m_sample_1D[dim][m_idx_current_pixel_sample];
+    // 1D and 2D dimensions take apart mask dimensions.
+    return m_blue_noise ? dither(u, 3 * dim) : u;
   } else {
     SWarn(
         "PixelSampler::sample_1D: Dimension index out of range, "
@@ -92,8 +165,19 @@ Float PixelSampler::sample_1D() {
   }
 }
 Point2f PixelSampler::sample_2D() {
+  if ((size_t)m_idx_current_2D == m_sample_2D.size() &&
+      m_idx_current_2D < MaxDimensions) {
+    add_dimensions(0, m_idx_current_2D + 1);
+    dimensions_extended++;
+  }
   if ((size_t)m_idx_current_2D < m_sample_2D.size()) {
-    return m_sample_2D[m_idx_current_2D++][m_idx_current_pixel_sample];
+    if (m_idx_current_2D == m_n_filled_2D) fill_2D(m_n_filled_2D++);
+    int dim = m_idx_current_2D++;
+    Point2f u = m_sample_2D[dim][m_idx_current_pixel_sample];
+    // The first is the point on film.
+    if (m_blue_noise && dim > 0)
+      u = Point2f(dither(u.x, 3 * dim + 1), dither(u.y, 3 * dim + 2));
+    return u;
   } else {
     SWarn(
         "PixelSampler::sample_2D: Dimension index out of range, "
@@ -113,30 +197,34 @@ void GlobalSampler::start_pixel(const Point2i &p) {
   // Fill sample arrays from global sequences.
   for (size_t i = 0; i < m_1D_array_sizes.size(); i++) {
     int n_samples = m_1D_array_sizes[i] * m_spp;
+    int64_t idx = m_global_idx_current_sample;
     for (int j = 0; j < n_samples; j++) {
-      int64_t idx = global_index(j);
+      if (j > 0) idx = next_global_index(idx, j);
       m_sample_1D_array[i][j] =
-          value_by_dimension(idx, m_idx_array_start_dim + i);
+          value_by_dimension(m_blue_noise ? j : idx, m_idx_array_start_dim + i);
     }
   }
   // 1D and 2D arrays consume the same sequence.
   int dim = m_idx_array_start_dim + m_1D_array_sizes.size();
   for (size_t i = 0; i < m_2D_array_sizes.size(); i++) {
     int n_samples = m_2D_array_sizes[i] * m_spp;
+    int64_t idx = m_global_idx_current_sample;
+    Float xy[2];
     for (int j = 0; j < n_samples; j++) {
-      int64_t idx = global_index(j);
-      m_sample_2D_array[i][j].x =
-          value_by_dimension(idx, m_idx_array_start_dim + dim);
-      m_sample_2D_array[i][j].y =
-          value_by_dimension(idx, m_idx_array_start_dim + dim + 1);
+      if (j > 0) idx = next_global_index(idx, j);
+      values_by_dimension(m_blue_noise ? j : idx, m_idx_array_start_dim + dim,
+                          2, xy);
+      m_sample_2D_array[i][j] = Point2f(xy[0], xy[1]);
     }
     dim += 2;
   }
   ASSERT(dim == m_idx_array_end_dim);
+  if (m_blue_noise) dither_arrays();
 }
 bool GlobalSampler::next_sample() {
   m_dimension = 0;
-  m_global_idx_current_sample = global_index(m_idx_current_pixel_sample + 1);
+  m_global_idx_current_sample = next_global_index(
+      m_global_idx_current_sample, m_idx_current_pixel_sample + 1);
   return Sampler::next_sample();
 }
 bool GlobalSampler::set_sample_index(int64_t idx) {
@@ -149,7 +237,10 @@ Float GlobalSampler::sample_1D() {
   // Skip dimensions for the arrays.
   if (m_idx_array_start_dim <= m_dimension && m_dimension < m_idx_array_end_dim)
     m_dimension = m_idx_array_end_dim;
-  return value_by_dimension(m_global_idx_current_sample, m_dimension++);
+  int dim = m_dimension++;
+  if (m_blue_noise && dim >= 2)
+    return dither(value_by_dimension(m_idx_current_pixel_sample, dim), dim);
+  return value_by_dimension(m_global_idx_current_sample, dim);
 }
 Point2f GlobalSampler::sample_2D() {
   // Skip dimensions for the arrays.
@@ -157,9 +248,14 @@ Point2f GlobalSampler::sample_2D() {
   if (m_idx_array_start_dim <= m_dimension + 1 &&
       m_dimension < m_idx_array_end_dim)
     m_dimension = m_idx_array_end_dim;
-  Float x = value_by_dimension(m_global_idx_current_sample, m_dimension);
-  Float y = value_by_dimension(m_global_idx_current_sample, m_dimension + 1);
+  Float xy[2];
+  int dim = m_dimension;
   m_dimension += 2;
-  return Point2f(x, y);
+  if (m_blue_noise && dim >= 2) {
+    values_by_dimension(m_idx_current_pixel_sample, dim, 2, xy);
+    return Point2f(dither(xy[0], dim), dither(xy[1], dim + 1));
+  }
+  values_by_dimension(m_global_idx_current_sample, dim, 2, xy);
+  return Point2f(xy[0], xy[1]);
 }
 }  // namespace TRay
\ No newline at end of file
@@ -0,0 +1,95 @@
+#include "core/checkpoint.h"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+#include "core/fileio.h"
+#include "core/stringformat.h"
+
+namespace TRay {
+namespace fs = std::filesystem;
+
+static const char kCheckpointMagic[4] = {'T', 'R', 'C', 'P'};
+static constexpr uint32_t kCheckpointVersion = 1;
+
+/// @brief Offset of the pixels, after the header and the tile flags.
+static size_t pixel_offset(uint32_t n_tiles) {
+  return (sizeof(FilmCheckpointHeader) + n_tiles + 15) / 16 * 16;
+}
+
+FilmCheckpoint::~FilmCheckpoint() {
+  if (m_pending.valid()) m_pending.wait();
+}
+int FilmCheckpoint::resume(Film *film, std::vector<uint8_t> *done) {
+  std::ifstream in(m_path, std::ios::binary);
+  if (!in) return 0;
+  Vector2i size = film->m_cropped_pixel_bound.diagonal();
+  uint32_t n_tiles = uint32_t(done->size());
+  FilmCheckpointHeader header;
+  if (!in.read(reinterpret_cast<char *>(&header), sizeof(header)) ||
+      memcmp(header.magic, kCheckpointMagic, 4) != 0 ||
+      header.version != kCheckpointVersion ||
+      header.float_size != sizeof(Float) || header.n_tiles != n_tiles ||
+      header.width != size.x || header.height != size.y ||
+      header.key != m_key) {
+    SInfo("FilmCheckpoint:: Ignoring " + m_path + ", render changed");
+    return 0;
+  }
+  std::vector<uint8_t> flags(n_tiles);
+  in.read(reinterpret_cast<char *>(flags.data()), n_tiles);
+  in.seekg(std::streamoff(pixel_offset(n_tiles)));
+  // Read aside, the film is left alone if the file is short.
+  size_t n_pixels = size_t(size.x) * size.y;
+  std::vector<Pixel> pixels(n_pixels);
+  if (!in.read(reinterpret_cast<char *>(pixels.data()),
+               std::streamsize(n_pixels * sizeof(Pixel)))) {
+    SWarn("FilmCheckpoint:: Ignoring truncated " + m_path);
+    return 0;
+  }
+  std::copy(pixels.begin(), pixels.end(), film->pixels());
+  int n_done = 0;
+  for (uint32_t i = 0; i < n_tiles; i++) {
+    (*done)[i] = flags[i] != 0;
+    n_done += (*done)[i];
+  }
+  SInfo(string_format("FilmCheckpoint:: Resumed %d/%d tiles from %s", n_done,
+                      int(n_tiles), m_path.c_str()));
+  return n_done;
+}
+void FilmCheckpoint::tile_done(const Film &film,
+                               const std::vector<uint8_t> &done) {
+  auto now = std::chrono::steady_clock::now();
+  if (std::chrono::duration<double>(now - m_last).count() < m_interval) return;
+  if (m_pending.valid() &&
+      m_pending.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+    return;
+  m_last = now;
+  // The copy is the only work done on the rendering thread.
+  Vector2i size = film.m_cropped_pixel_bound.diagonal();
+  uint32_t n_tiles = uint32_t(done.size());
+  size_t offset = pixel_offset(n_tiles);
+  size_t n_pixels = size_t(size.x) * size.y;
+  auto image = std::make_shared<std::vector<uint8_t>>(
+      offset + n_pixels * sizeof(Pixel), 0);
+  FilmCheckpointHeader header;
+  memcpy(header.magic, kCheckpointMagic, 4);
+  header.version = kCheckpointVersion;
+  header.float_size = sizeof(Float);
+  header.n_tiles = n_tiles;
+  header.width = size.x;
+  header.height = size.y;
+  header.key = m_key;
+  memcpy(image->data(), &header, sizeof(header));
+  memcpy(image->data() + sizeof(header), done.data(), n_tiles);
+  memcpy(image->data() + offset, film.pixels(), n_pixels * sizeof(Pixel));
+  m_pending = std::async(std::launch::async, [path = m_path, image] {
+    return write_file_replacing(path, image->data(), image->size());
+  });
+}
+void FilmCheckpoint::finish() {
+  if (m_pending.valid()) m_pending.wait();
+  std::error_code ec;
+  fs::remove(m_path, ec);
+}
+}  // namespace TRay
@@ -0,0 +1,64 @@
+#include "core/fileio.h"
+
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+
+#include "core/stringformat.h"
+
+#ifdef TRAY_ON_WINDOWS
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace TRay {
+namespace fs = std::filesystem;
+
+bool file_identity(const std::string &path, uint64_t *size, int64_t *mtime) {
+  std::error_code ec;
+  *size = fs::file_size(path, ec);
+  if (ec) return false;
+  auto time = fs::last_write_time(path, ec);
+  if (ec) return false;
+  *mtime = int64_t(time.time_since_epoch().count());
+  return true;
+}
+std::string temp_path(const std::string &path) {
+  static std::atomic<int> counter{0};
+#ifdef TRAY_ON_WINDOWS
+  long long pid = GetCurrentProcessId();
+#else
+  long long pid = getpid();
+#endif
+  return string_format("%s.%lld.%d.tmp", path.c_str(), pid, counter++);
+}
+bool write_file_replacing(const std::string &path, const void *data,
+                          size_t size) {
+  std::string tmp_path = temp_path(path);
+  {
+    std::ofstream out(tmp_path, std::ios::binary | std::ios::trunc);
+    out.write(static_cast<const char *>(data), std::streamsize(size));
+    if (!out) {
+      SWarn("Failed writing " + tmp_path);
+      return false;
+    }
+  }
+  std::error_code ec;
+  fs::rename(tmp_path, path, ec);
+  if (ec) {
+    // Windows does not replace an existing file.
+    fs::remove(path, ec);
+    fs::rename(tmp_path, path, ec);
+  }
+  if (ec) {
+    SWarn("Failed writing " + path + ", " + ec.message());
+    fs::remove(tmp_path, ec);
+    return false;
+  }
+  return true;
+}
+}  // namespace TRay
@@ -27,6 +27,19 @@ bool Transform::has_scale() const {
   return (NOT_ONE(la2) || NOT_ONE(lb2) || NOT_ONE(lc2));
 #undef NOT_ONE
 }
+bool Transform::is_translate_uniform_scale(Vector3f *translation,
+                                           Float *scale) const {
+  const Float(&v)[4][4] = m.val;
+  for (int i = 0; i < 3; i++)
+    for (int j = 0; j < 3; j++)
+      if (i != j && v[i][j] != 0) return false;
+  if (v[3][0] != 0 || v[3][1] != 0 || v[3][2] != 0 || v[3][3] != 1)
+    return false;
+  if (v[0][0] <= 0 || v[0][0] != v[1][1] || v[0][0] != v[2][2]) return false;
+  if (translation) *translation = Vector3f(v[0][3], v[1][3], v[2][3]);
+  if (scale) *scale = v[0][0];
+  return true;
+}
 bool Transform::will_swap_hand() const {
   Float det =
       m.val[0][0] * (m.val[1][1] * m.val[2][2] - m.val[1][2] * m.val[2][1]) +
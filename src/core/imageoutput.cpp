@@ -0,0 +1,87 @@
+#include "core/imageoutput.h"
+
+#include <limits>
+
+#include "core/statistics.h"
+#include "stb_image_write.h"
+
+namespace TRay {
+bool is_float_image(const std::string &filename) {
+  return filename.size() >= 4 &&
+         filename.compare(filename.size() - 4, 4, ".pfm") == 0;
+}
+
+ImageOutput::ImageOutput() : m_thread(&ImageOutput::run, this) {}
+ImageOutput::~ImageOutput() {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stop = true;
+  }
+  m_cv_work.notify_one();
+  m_thread.join();
+}
+void ImageOutput::begin(const std::shared_ptr<Film> &film) {
+  m_film = film;
+  m_image = nullptr;
+  if (is_float_image(film->m_filename)) return;
+  Vector2i size = film->m_cropped_pixel_bound.diagonal();
+  m_image = std::make_shared<std::vector<uint8_t>>(size_t(size.x) * size.y *
+                                                   3);
+  // Rows are not touched by the integrator once final, they can be read
+  // while it renders the others.
+  auto image = m_image;
+  Film *raw_film = film.get();
+  film->set_rows_callback([this, image, raw_film](int y0, int y1) {
+    push([=] { raw_film->write_image_rows(y0, y1, image->data()); });
+  });
+}
+void ImageOutput::finish() {
+  if (!m_film) return;
+  std::shared_ptr<Film> film = std::move(m_film);
+  std::shared_ptr<std::vector<uint8_t>> image = std::move(m_image);
+  // Rows of integrators that do not report them.
+  film->samples_merged_below(std::numeric_limits<int>::max());
+  film->set_rows_callback(nullptr);
+  push([film, image] {
+    const std::string &name = film->m_filename;
+    if (!image) {
+      film->write_pfm(name);
+      return;
+    }
+    Vector2i size = film->m_cropped_pixel_bound.diagonal();
+    if (!stbi_write_jpg(name.c_str(), size.x, size.y, 3, image->data(), 95))
+      SError("ImageOutput: Failed to write " + name);
+  });
+}
+void ImageOutput::wait() {
+  std::unique_lock<std::mutex> lock(m_mutex);
+  uint64_t target = m_pushed;
+  m_cv_done.wait(lock, [&] { return m_done >= target; });
+}
+void ImageOutput::push(std::function<void()> job) {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_jobs.push_back(std::move(job));
+    m_pushed++;
+  }
+  m_cv_work.notify_one();
+}
+void ImageOutput::run() {
+  std::unique_lock<std::mutex> lock(m_mutex);
+  while (true) {
+    m_cv_work.wait(lock, [&] { return m_stop || !m_jobs.empty(); });
+    if (m_jobs.empty()) break;
+    std::function<void()> job = std::move(m_jobs.front());
+    m_jobs.pop_front();
+    lock.unlock();
+    job();
+    // Release the film before reporting it written.
+    job = nullptr;
+    // Not at thread exit, the output may outlive the statistics.
+    ReportThreadStats();
+    lock.lock();
+    m_done++;
+    m_cv_done.notify_all();
+  }
+}
+}  // namespace TRay
\ No newline at end of file
@@ -0,0 +1,161 @@
+#include "core/logging.h"
+
+#include <condition_variable>
+#include <csignal>
+#include <cstdio>
+#include <deque>
+#include <exception>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "core/stringformat.h"
+
+namespace TRay {
+namespace {
+const char *kLevelPrefix[] = {"[D]", "[I]", "-[W]", "--[E]", "----[C]"};
+
+/// @brief Set once the writer thread is gone. Messages logged later during
+///        static destruction are written synchronously.
+std::atomic<bool> writer_destroyed{false};
+
+std::mutex muted_mutex;
+std::vector<LogSite *> muted_sites;
+/// @brief Summary lines for the call sites muted since last time.
+std::vector<std::string> take_muted_reports() {
+  std::vector<LogSite *> sites;
+  {
+    std::lock_guard<std::mutex> lock(muted_mutex);
+    sites.swap(muted_sites);
+  }
+  std::vector<std::string> lines;
+  for (LogSite *site : sites) {
+    // Report again if it gets muted later on.
+    site->reset_muted();
+    lines.push_back(string_format(
+        "-[W]%s:%d logged %lld messages, most of them muted.\n", site->m_file,
+        site->m_line, (long long)site->count()));
+  }
+  return lines;
+}
+
+/// @brief Single background thread draining the message queue into
+///        std::cerr.
+class LogWriter {
+ public:
+  static LogWriter &instance() {
+    static LogWriter writer;
+    return writer;
+  }
+  ~LogWriter() {
+    for (auto &line : take_muted_reports()) push(std::move(line));
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_stop = true;
+    }
+    m_cv_work.notify_one();
+    m_thread.join();
+    writer_destroyed = true;
+  }
+  void push(std::string line) {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_queue.push_back(std::move(line));
+      m_pushed++;
+    }
+    m_cv_work.notify_one();
+  }
+  /// @brief Wait for everything pushed so far.
+  void flush() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    uint64_t target = m_pushed;
+    m_cv_done.wait(lock, [&] { return m_written >= target; });
+  }
+  /// @brief Write the queued lines from the aborting thread, without waiting
+  ///        for the writer. Best effort, the queue is skipped if it is locked.
+  void write_queued() {
+    std::unique_lock<std::mutex> lock(m_mutex, std::try_to_lock);
+    if (!lock.owns_lock()) return;
+    for (const auto &line : m_queue)
+      std::fwrite(line.data(), 1, line.size(), stderr);
+    m_queue.clear();
+    std::fflush(stderr);
+  }
+
+ private:
+  LogWriter() : m_thread(&LogWriter::run, this) {
+    // Lines still queued when the process goes down are written first.
+    static std::terminate_handler previous = std::set_terminate([] {
+      log_flush();
+      if (previous) previous();
+      std::abort();
+    });
+    std::signal(SIGABRT, on_abort);
+  }
+  static void on_abort(int sig) {
+    if (!writer_destroyed) instance().write_queued();
+    std::signal(sig, SIG_DFL);
+    std::raise(sig);
+  }
+  void run() {
+    std::deque<std::string> lines;
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true) {
+      m_cv_work.wait(lock, [&] { return m_stop || !m_queue.empty(); });
+      if (m_queue.empty() && m_stop) break;
+      lines.swap(m_queue);
+      lock.unlock();
+      // One write for the whole batch.
+      std::string batch;
+      for (const auto &line : lines) batch += line;
+      std::cerr << batch;
+      std::cerr.flush();
+      uint64_t n = lines.size();
+      lines.clear();
+      lock.lock();
+      m_written += n;
+      m_cv_done.notify_all();
+    }
+  }
+
+  std::mutex m_mutex;
+  std::condition_variable m_cv_work, m_cv_done;
+  std::deque<std::string> m_queue;
+  uint64_t m_pushed = 0, m_written = 0;
+  bool m_stop = false;
+  // Started last, after everything it uses.
+  std::thread m_thread;
+};
+
+void write_line(std::string line, bool sync) {
+  if (writer_destroyed) {
+    std::cerr << line;
+    return;
+  }
+  LogWriter &writer = LogWriter::instance();
+  writer.push(std::move(line));
+  if (sync) writer.flush();
+}
+}  // namespace
+
+void LogSite::register_muted() {
+  std::lock_guard<std::mutex> lock(muted_mutex);
+  muted_sites.push_back(this);
+}
+
+void log_message(LogLevel level, const LogSite &site, int64_t n,
+                 const std::string &msg) {
+  std::string line = kLevelPrefix[int(level)] + msg;
+  if (level >= LogLevel::Warning && n >= kLogBurst)
+    line += string_format(" (x%lld from %s:%d, muting the others)",
+                          (long long)(n + 1), site.m_file, site.m_line);
+  line += '\n';
+  write_line(std::move(line), level >= LogLevel::Error);
+}
+
+void log_flush() {
+  for (auto &line : take_muted_reports()) write_line(std::move(line), false);
+  if (!writer_destroyed) LogWriter::instance().flush();
+}
+}  // namespace TRay
\ No newline at end of file
@@ -0,0 +1,79 @@
+#include "core/math/bluenoise.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+#include "core/stringformat.h"
+
+namespace TRay {
+static const char kBlueNoiseMagic[4] = {'T', 'R', 'B', 'N'};
+static constexpr uint32_t kBlueNoiseVersion = 1;
+
+BlueNoiseMask::BlueNoiseMask(int size, int n_channels,
+                             std::vector<uint16_t> ranks)
+    : m_size(size), m_n_channels(n_channels), m_ranks(std::move(ranks)) {
+  ASSERT(0 < size && size <= MaxSize && n_channels > 0);
+  ASSERT(m_ranks.size() == size_t(size) * size * n_channels);
+}
+std::shared_ptr<const BlueNoiseMask> BlueNoiseMask::load(
+    const std::string &path) {
+  FILE *f = fopen(path.c_str(), "rb");
+  if (!f) {
+    SError("BlueNoiseMask::load: Failed to open " + path);
+    return nullptr;
+  }
+  BlueNoiseHeader header;
+  if (fread(&header, sizeof(header), 1, f) != 1 ||
+      memcmp(header.magic, kBlueNoiseMagic, 4) != 0 ||
+      header.version != kBlueNoiseVersion || header.size == 0 ||
+      header.size > MaxSize || header.n_channels == 0) {
+    SError("BlueNoiseMask::load: Not a blue-noise mask, " + path);
+    fclose(f);
+    return nullptr;
+  }
+  size_t n = size_t(header.size) * header.size * header.n_channels;
+  std::vector<uint16_t> ranks(n);
+  bool ok = fread(ranks.data(), sizeof(uint16_t), n, f) == n;
+  fclose(f);
+  if (!ok) {
+    SError("BlueNoiseMask::load: Truncated mask " + path);
+    return nullptr;
+  }
+  SInfo(string_format("BlueNoiseMask::load: %dx%d, %d channels from %s",
+                      int(header.size), int(header.size),
+                      int(header.n_channels), path.c_str()));
+  return std::make_shared<const BlueNoiseMask>(
+      int(header.size), int(header.n_channels), std::move(ranks));
+}
+bool BlueNoiseMask::write(const std::string &path) const {
+  BlueNoiseHeader header;
+  memcpy(header.magic, kBlueNoiseMagic, 4);
+  header.version = kBlueNoiseVersion;
+  header.size = m_size;
+  header.n_channels = m_n_channels;
+  FILE *f = fopen(path.c_str(), "wb");
+  if (!f) {
+    SError("BlueNoiseMask::write: Failed to open " + path);
+    return false;
+  }
+  bool ok = fwrite(&header, sizeof(header), 1, f) == 1 &&
+            fwrite(m_ranks.data(), sizeof(uint16_t), m_ranks.size(), f) ==
+                m_ranks.size();
+  ok = fclose(f) == 0 && ok;
+  if (!ok) SError("BlueNoiseMask::write: Failed to write " + path);
+  return ok;
+}
+Float BlueNoiseMask::value(const Point2i &p, int dim) const {
+  int channel = dim % m_n_channels, shift = dim / m_n_channels;
+  // R2 offsets of the tile, well apart for any number of shifts.
+  double ox = shift * 0.7548776662466927, oy = shift * 0.5698402909980532;
+  int x = p.x + int((ox - std::floor(ox)) * m_size);
+  int y = p.y + int((oy - std::floor(oy)) * m_size);
+  // Pixels of the sample bound may be negative.
+  x = (x % m_size + m_size) % m_size;
+  y = (y % m_size + m_size) % m_size;
+  uint16_t rank = m_ranks[(size_t(channel) * m_size + y) * m_size + x];
+  return (rank + Float(0.5)) / (m_size * m_size);
+}
+}  // namespace TRay
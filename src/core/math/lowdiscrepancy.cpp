@@ -1,23 +1,122 @@
 #include "core/math/lowdiscrepancy.h"
+
+#include <array>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+#include "core/math/RNG.h"
 #include "core/stringformat.h"
 
 namespace TRay {
-inline uint32_t reverse_bit32(uint32_t n) {
-  n = (n << 16) | (n >> 16);
-  n = ((n & 0x00ff00ff) << 8) | ((n & 0xff00ff00) >> 8);
-  n = ((n & 0x0f0f0f0f) << 4) | ((n & 0xf0f0f0f0) >> 4);
-  n = ((n & 0x33333333) << 2) | ((n & 0xcccccccc) >> 2);
-  n = ((n & 0x55555555) << 1) | ((n & 0xaaaaaaaa) >> 1);
-  return n;
-}
 inline uint64_t reverse_bit64(uint64_t n) {
   uint64_t n0 = reverse_bit32(uint32_t(n));
   uint64_t n1 = reverse_bit32(uint32_t(n >> 32));
   return (n0 << 32) | n1;
 }
+/// @brief The bases of radical_inverse().
+static constexpr std::array<int, NPrimes> Primes = [] {
+  std::array<int, NPrimes> primes{};
+  int n = 0;
+  for (int v = 2; n < NPrimes; v++) {
+    bool is_prime = true;
+    for (int i = 0; i < n && primes[i] * primes[i] <= v; i++)
+      if (v % primes[i] == 0) {
+        is_prime = false;
+        break;
+      }
+    if (is_prime) primes[n++] = v;
+  }
+  return primes;
+}();
+// Entries of the biggest digit table.
+static constexpr int MaxDigitTableSize = 1024;
+static constexpr int pow_int(int base, int n) {
+  int ret = 1;
+  while (n--) ret *= base;
+  return ret;
+}
+/// @brief Number of digits of @param base reversed by one table lookup.
+static constexpr int digits_per_step(int base) {
+  int n = 1;
+  for (int size = base; size * base <= MaxDigitTableSize; size *= base) n++;
+  return n;
+}
+/// @brief Fill the digit tables of @param base, see DigitTables.
+/// @param perm Permutation of the digits.
+/// @param n_last Skipped if null.
+static constexpr void fill_digit_tables(int base, const uint16_t *perm,
+                                        uint16_t *full, uint16_t *last,
+                                        uint8_t *n_last) {
+  int n_digits = digits_per_step(base);
+  int size = pow_int(base, n_digits);
+  for (int v = 0; v < size; v++) {
+    int a = v, full_rev = 0;
+    for (int i = 0; i < n_digits; i++, a /= base)
+      full_rev = full_rev * base + perm[a % base];
+    int n = 0, last_rev = 0;
+    for (a = v; a; a /= base, n++) last_rev = last_rev * base + perm[a % base];
+    full[v] = uint16_t(full_rev);
+    last[v] = uint16_t(last_rev);
+    if (n_last) n_last[v] = uint8_t(n);
+  }
+}
+/// @brief Tables to reverse the digits of base_val several at a time, for
+///        bases with more than one digit per step.
+template <int base_val>
+struct DigitTables {
+  static constexpr int n_digits = digits_per_step(base_val);
+  static constexpr int size = pow_int(base_val, n_digits);
+  // Reversed digits of a value below size, with all n_digits digits, and
+  // with only its own n_last digits as for the most significant ones.
+  uint16_t full[size] = {}, last[size] = {};
+  uint8_t n_last[size] = {};
+  uint64_t pow[n_digits + 1] = {};
+  // base_val^-n, multiplied up one digit at a time as in the digit loop.
+  Float inv_pow[65] = {};
+
+  constexpr DigitTables() {
+    uint16_t identity[base_val] = {};
+    for (int i = 0; i < base_val; i++) identity[i] = uint16_t(i);
+    fill_digit_tables(base_val, identity, full, last, n_last);
+    pow[0] = 1;
+    for (int i = 1; i <= n_digits; i++) pow[i] = pow[i - 1] * base_val;
+    const Float base_inv = Float(1) / Float(base_val);
+    inv_pow[0] = 1;
+    for (int i = 1; i < 65; i++) inv_pow[i] = inv_pow[i - 1] * base_inv;
+  }
+};
+/// @brief Reverse the digits of @param a in base_val with @param full and
+///        @param last, see DigitTables.
+/// @param n Gets the number of digits.
+template <int base_val>
+static uint64_t reverse_digits(uint64_t a, const uint16_t *full,
+                               const uint16_t *last, int *n) {
+  using Tables = DigitTables<base_val>;
+  static constexpr Tables tables;
+  constexpr uint64_t step = Tables::size;
+  uint64_t inverse_digits = 0;
+  *n = 0;
+  while (a >= step) {
+    uint64_t next = a / step;
+    inverse_digits = inverse_digits * step + full[a - next * step];
+    *n += Tables::n_digits;
+    a = next;
+  }
+  int n_last = tables.n_last[a];
+  *n += n_last;
+  return inverse_digits * tables.pow[n_last] + last[a];
+}
 /// @brief Specialized version of radical inverse, for optimizing.
 template <int base_val>
 static Float radical_inverse_special(uint64_t a) {
+  if constexpr (digits_per_step(base_val) > 1) {
+    static constexpr DigitTables<base_val> tables;
+    int n;
+    uint64_t inverse_digits =
+        reverse_digits<base_val>(a, tables.full, tables.last, &n);
+    return std::min(inverse_digits * tables.inv_pow[n], ONE_M_EPS);
+  }
   const Float base_inv = Float(1) / Float(base_val);
   Float baseN_inv = 1;
   uint64_t inverse_digits = 0;
@@ -31,6 +130,159 @@ static Float radical_inverse_special(uint64_t a) {
   }
   return std::min(inverse_digits * baseN_inv, ONE_M_EPS);
 }
+/// @brief Specialized version of scrambled radical inverse.
+/// @param tables See DigitPermutations::tables().
+template <int base_val>
+static Float scrambled_radical_inverse_special(uint64_t a,
+                                               const uint16_t *tables) {
+  const uint16_t *perm = tables;
+  const Float base_inv = Float(1) / Float(base_val);
+  // The infinite zeros beyond the last digit, permuted.
+  const Float tail = base_inv * perm[0] / (1 - base_inv);
+  if constexpr (digits_per_step(base_val) > 1) {
+    using Tables = DigitTables<base_val>;
+    static constexpr Tables identity;
+    const uint16_t *full = tables + base_val;
+    int n;
+    uint64_t inverse_digits =
+        reverse_digits<base_val>(a, full, full + Tables::size, &n);
+    return std::min(identity.inv_pow[n] * (inverse_digits + tail),
+                    ONE_M_EPS);
+  }
+  Float baseN_inv = 1;
+  uint64_t inverse_digits = 0;
+  while (a) {
+    uint64_t next = a / base_val;
+    uint64_t last_digit = a - next * base_val;
+    inverse_digits = inverse_digits * base_val + perm[last_digit];
+    baseN_inv *= base_inv;
+    a = next;
+  }
+  return std::min(baseN_inv * (inverse_digits + tail), ONE_M_EPS);
+}
+using ScrambledRadicalInverse = Float (*)(uint64_t, const uint16_t *);
+template <size_t... I>
+static constexpr std::array<ScrambledRadicalInverse, NPrimes>
+make_scrambled_radical_inverses(std::index_sequence<I...>) {
+  return {&scrambled_radical_inverse_special<Primes[I]>...};
+}
+static constexpr std::array<ScrambledRadicalInverse, NPrimes>
+    ScrambledRadicalInverses =
+        make_scrambled_radical_inverses(std::make_index_sequence<NPrimes>());
+
+DigitPermutations::DigitPermutations(RNG &rng) : m_offsets(NPrimes) {
+  size_t n_entries = 0;
+  for (int i = 0; i < NPrimes; i++) {
+    m_offsets[i] = n_entries;
+    int base = Primes[i];
+    n_entries += base;
+    if (digits_per_step(base) > 1)
+      n_entries += 2 * pow_int(base, digits_per_step(base));
+  }
+  m_tables.resize(n_entries);
+  for (int i = 0; i < NPrimes; i++) {
+    int base = Primes[i];
+    uint16_t *perm = m_tables.data() + m_offsets[i];
+    std::iota(perm, perm + base, uint16_t(0));
+    rng.shuffle(perm, perm + base);
+    if (digits_per_step(base) > 1) {
+      uint16_t *full = perm + base;
+      fill_digit_tables(base, perm, full,
+                        full + pow_int(base, digits_per_step(base)), nullptr);
+    }
+  }
+}
+Float scrambled_radical_inverse(int base_idx, uint64_t a,
+                                const DigitPermutations &perms) {
+  if (base_idx < 0 || base_idx >= NPrimes) {
+    SError(string_format("Base index %d is out-of-range. Zero is returned.",
+                         base_idx));
+    return 0;
+  }
+  return ScrambledRadicalInverses[base_idx](a, perms.tables(base_idx));
+}
+/// @brief Fill the byte tables of matrices @param M, see Sobol_table32().
+template <typename T>
+static std::vector<T> make_Sobol_table(const T *M) {
+  std::vector<T> table(NSobolTableBytes * 256 * NSobolTableDimensions, 0);
+  for (int g = 0; g < NSobolTableBytes; g++) {
+    for (int byte_val = 0; byte_val < 256; byte_val++) {
+      T *row = &table[Sobol_table_offset(g, byte_val)];
+      for (int d = 0; d < NSobolTableDimensions; d++) {
+        for (int bit = 0; bit < 8 && g * 8 + bit < SobolMatrixSize; bit++)
+          if (byte_val & (1 << bit))
+            row[d] ^= M[d * SobolMatrixSize + g * 8 + bit];
+      }
+    }
+  }
+  return table;
+}
+const uint32_t *Sobol_table32() {
+  static const std::vector<uint32_t> table = make_Sobol_table(SobolMatrices32);
+  return table.data();
+}
+const uint64_t *Sobol_table64() {
+  static const std::vector<uint64_t> table = make_Sobol_table(SobolMatrices64);
+  return table.data();
+}
+void sample_Sobol(int64_t global_index, int dimension, int n, Float *values,
+                  uint64_t scramble) {
+  // Dimensions in the tables, a byte of the index at a time for all of them.
+  int n_table = std::max(0, std::min(n, NSobolTableDimensions - dimension));
+  if (n_table > 0) {
+#ifdef TRAY_FLOAT_AS_DOUBLE
+    const uint64_t *table = Sobol_table64() + dimension;
+    uint64_t v[NSobolTableDimensions];
+    // As in sample_Sobol_double.
+    uint64_t init = uint32_t(scramble) & ~-(1ll << SobolMatrixSize);
+#else
+    const uint32_t *table = Sobol_table32() + dimension;
+    uint32_t v[NSobolTableDimensions];
+    uint32_t init = uint32_t(scramble);
+#endif
+    for (int d = 0; d < n_table; d++) v[d] = init;
+    uint64_t a = global_index;
+    for (int g = 0; a != 0 && g < NSobolTableBytes; a >>= 8, ++g) {
+      const auto *row = table + Sobol_table_offset(g, a & 0xff);
+      for (int d = 0; d < n_table; d++) v[d] ^= row[d];
+    }
+    for (int d = 0; d < n_table; d++) {
+#ifdef TRAY_FLOAT_AS_DOUBLE
+      values[d] = float(
+          std::min(v[d] * (1.0 / (1ull << SobolMatrixSize)), ONE_M_EPS));
+#else
+      values[d] = v[d] * 0x1p-32f;
+#endif
+    }
+  }
+  for (int d = n_table; d < n; d++)
+    values[d] = sample_Sobol(global_index, dimension + d, scramble);
+}
+ZeroTwoTable::ZeroTwoTable(uint32_t n) : m_x(n), m_y(n) {
+  ASSERT(is_pow2(n));
+  // Second Sobol' matrix, the first is the identity of van der Corput.
+  static const uint32_t CSobol1[32] = {
+      // clang-format off
+      0x80000000, 0xc0000000, 0xa0000000, 0xf0000000,
+      0x88000000, 0xcc000000, 0xaa000000, 0xff000000,
+      0x80800000, 0xc0c00000, 0xa0a00000, 0xf0f00000,
+      0x88880000, 0xcccc0000, 0xaaaa0000, 0xffff0000,
+      0x80008000, 0xc000c000, 0xa000a000, 0xf000f000,
+      0x88008800, 0xcc00cc00, 0xaa00aa00, 0xff00ff00,
+      0x80808080, 0xc0c0c0c0, 0xa0a0a0a0, 0xf0f0f0f0,
+      0x88888888, 0xcccccccc, 0xaaaaaaaa, 0xffffffff
+      // clang-format on
+  };
+  uint32_t x = 0, y = 0;
+  for (uint32_t i = 0; i < n; ++i) {
+    m_x[i] = x;
+    m_y[i] = y;
+    // The changed bit of the Gray code is the # of trailing zeros of i + 1.
+    int bit = ctz(i + 1);
+    x ^= 0x80000000u >> bit;
+    y ^= CSobol1[bit];
+  }
+}
 Float radical_inverse(int base_idx, uint64_t a) {
   switch (base_idx) {
     case 0:
@@ -23,9 +23,34 @@ void ReportThreadStats() {
   std::lock_guard<std::mutex> lock(cb_mutex);
   StatReporter::CallCallbacks(statsAccumulator);
 }
-void PrintStats(std::ostream &o) { statsAccumulator.Print(o); }
+void PrintStats(std::ostream &o) {
+  // Keep queued log lines ahead of the stats.
+  log_flush();
+  statsAccumulator.Print(o);
+}
+
+STAT_MEMORY("Memory/total", total_memory);
+void MemoryCounter::update(int64_t bytes) {
+  int64_t live = m_live.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+  int64_t peak = m_peak.load(std::memory_order_relaxed);
+  while (live > peak &&
+         !m_peak.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {
+  }
+}
+void MemoryCounter::allocate(int64_t bytes) {
+  if (bytes == 0) return;
+  update(bytes);
+  if (this != &total_memory) total_memory.update(bytes);
+}
 void ClearStats() { statsAccumulator.Clear(); }
 
+/// @brief Human readable size.
+static std::string FormatBytes(int64_t bytes) {
+  if (std::abs(bytes) < 1024) return string_format("%lld B", bytes);
+  if (std::abs(bytes) < 1024 * 1024)
+    return string_format("%.2f KiB", bytes / 1024.0);
+  return string_format("%.2f MiB", bytes / (1024.0 * 1024.0));
+}
 static void SplitCategory(const std::string &category, std::string *main_cat,
                           std::string *sub_cat) {
   size_t idx = category.find_first_of('/');
@@ -48,6 +73,16 @@ void StatsAccumulator::Print(std::ostream &o) {
     print_buffer[main_cat].push_back(
         string_format("%-16s: %lld", sub_cat.c_str(), counter.second));
   }
+  // Memory.
+  for (auto memory : m_memory) {
+    std::string main_cat, sub_cat;
+    SplitCategory(memory.first, &main_cat, &sub_cat);
+    if (main_cat.empty()) main_cat = "Single category:";
+    print_buffer[main_cat].push_back(string_format(
+        "%-16s: %s live, %s peak", sub_cat.c_str(),
+        FormatBytes(memory.second.first).c_str(),
+        FormatBytes(memory.second.second).c_str()));
+  }
   // Main print.
   for (auto category : print_buffer) {
     o << string_format("  %s\n", category.first.c_str());
@@ -58,6 +93,7 @@ void StatsAccumulator::Print(std::ostream &o) {
 void StatsAccumulator::Clear() {
   ///
   m_counters.clear();
+  m_memory.clear();
 }
 
 // For tests.
@@ -0,0 +1,82 @@
+#include "core/validation.h"
+
+#include "core/statistics.h"
+
+namespace TRay {
+STAT_COUNTER("Integrator/radiance_nan", nan_counter);
+STAT_COUNTER("Integrator/radiance_negative", negative_counter);
+STAT_COUNTER("Integrator/radiance_inf", inf_counter);
+
+static const char *issue_name(RadianceIssue issue) {
+  switch (issue) {
+    case RadianceIssue::NaN:
+      return "NaN";
+    case RadianceIssue::Negative:
+      return "negative";
+    case RadianceIssue::INF:
+      return "INF";
+    default:
+      return "valid";
+  }
+}
+
+void RadianceValidator::reset(const Bound2i &pixel_bound) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_pixel_bound = pixel_bound;
+  m_n_bad = 0;
+  m_records.clear();
+  m_mask.clear();
+}
+void RadianceValidator::record(const Spectrum *L, const Point2i &pixel,
+                               int64_t sample_index) {
+  // Same precedence as the checks used to have.
+  RadianceIssue issue = RadianceIssue::INF;
+  if (L->has_NaN()) {
+    issue = RadianceIssue::NaN;
+    nan_counter++;
+  } else if (L->y() < -1e-5) {
+    issue = RadianceIssue::Negative;
+    negative_counter++;
+  } else {
+    inf_counter++;
+  }
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_n_bad++;
+  if ((int)m_records.size() < kMaxRecords)
+    m_records.push_back({issue, pixel, sample_index});
+  if (!point_in_bound_open(pixel, m_pixel_bound)) return;
+  if (m_mask.empty()) m_mask.resize(std::max(0, m_pixel_bound.area()), 0);
+  int width = m_pixel_bound.p_max.x - m_pixel_bound.p_min.x;
+  m_mask[(pixel.y - m_pixel_bound.p_min.y) * width +
+         (pixel.x - m_pixel_bound.p_min.x)] |= uint8_t(issue);
+}
+void RadianceValidator::report() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (m_n_bad == 0) return;
+  std::string msg = string_format(
+      "RadianceValidator: %lld samples were invalid and set to black.",
+      (long long)m_n_bad);
+  for (const BadSample &bad : m_records)
+    msg += string_format("\n\t%s radiance for pixel (%d, %d), sample %lld",
+                         issue_name(bad.issue), bad.pixel.x, bad.pixel.y,
+                         (long long)bad.sample_index);
+  if (m_n_bad > (int64_t)m_records.size())
+    msg += string_format("\n\t... only the first %d are listed.", kMaxRecords);
+  SError(msg);
+}
+bool RadianceValidator::bad_pixel_mask(std::vector<uint8_t> *rgb,
+                                       Point2i *resolution) const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (m_mask.empty()) return false;
+  *resolution = Point2i(m_pixel_bound.p_max.x - m_pixel_bound.p_min.x,
+                        m_pixel_bound.p_max.y - m_pixel_bound.p_min.y);
+  rgb->resize(m_mask.size() * 3);
+  for (size_t i = 0; i < m_mask.size(); i++) {
+    (*rgb)[3 * i + 0] = (m_mask[i] & uint8_t(RadianceIssue::NaN)) ? 255 : 0;
+    (*rgb)[3 * i + 1] =
+        (m_mask[i] & uint8_t(RadianceIssue::Negative)) ? 255 : 0;
+    (*rgb)[3 * i + 2] = (m_mask[i] & uint8_t(RadianceIssue::INF)) ? 255 : 0;
+  }
+  return true;
+}
+}  // namespace TRay
\ No newline at end of file
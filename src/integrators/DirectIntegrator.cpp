@@ -63,4 +63,10 @@ Spectrum DirectIntegrator::Li(const Ray &ray, const Scene &scene,
   }
   return L;
 }
+SampleDimensions DirectIntegrator::sample_dimensions(const Scene &) const {
+  // Each depth: specular reflection and transmission, and a light with its
+  // light and BSDF samples unless the arrays are used.
+  if (m_light_sample == LightSample::UNIFORM_ALL) return {0, 2 * m_max_depth};
+  return {m_max_depth, 4 * m_max_depth};
+}
 }  // namespace TRay
\ No newline at end of file
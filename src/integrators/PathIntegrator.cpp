@@ -111,4 +111,9 @@ Spectrum PathIntegrator::Li(const Ray &ray, const Scene &scene,
   // SDebug("current Li returned " + L.to_string() + "\n");
   return L;
 }
+SampleDimensions PathIntegrator::sample_dimensions(const Scene &) const {
+  // Each bounce: light selection and Russian roulette, light and BSDF
+  // samples of direct lighting, and the BSDF sample of the next ray.
+  return {2 * m_max_depth, 3 * m_max_depth};
+}
 }  // namespace TRay
\ No newline at end of file
@@ -61,4 +61,10 @@ Spectrum WhittedIntegrator::Li(const Ray &ray, const Scene &scene,
 
   return L;
 }
+SampleDimensions WhittedIntegrator::sample_dimensions(
+    const Scene &scene) const {
+  // Each depth: a sample for each light, specular reflection and
+  // transmission.
+  return {0, m_max_depth * (int(scene.m_lights.size()) + 2)};
+}
 }  // namespace TRay
\ No newline at end of file
@@ -1,15 +1,19 @@
 #include "loaders/SceneLoader.h"
 
+#include <chrono>
 #include <fstream>
 #include <nlohmann/json.hpp>
 
 #include "accelerators/accelerators.h"
 #include "cameras/cameras.h"
 #include "core/Film.h"
+#include "core/math/bluenoise.h"
+#include "core/parallel.h"
 #include "filters/filters.h"
 #include "integrators/integrators.h"
 #include "lights/lights.h"
 #include "loaders/KeyVal.h"
+#include "loaders/sceneparser.h"
 #include "materials/materials.h"
 #include "samplers/samplers.h"
 #include "shapes/shapes.h"
@@ -35,6 +39,26 @@ void get_float(const json &js, Float *x) {
 }
 
 namespace TRay {
+/// @brief Optional locality order of a mesh shape.
+static MeshOrder mesh_order(const json &shp) {
+  if (!shp.contains(Key::Reorder)) return MeshOrder::None;
+  std::string name = shp[Key::Reorder].get<std::string>();
+  if (name == Val::Morton) return MeshOrder::Morton;
+  if (name == Val::VertexCache) return MeshOrder::VertexCache;
+  if (name != Val::None) SWarn("Unknown mesh order " + name);
+  return MeshOrder::None;
+}
+
+std::vector<std::string> SceneLoader::referenced_files(
+    const json &scene_file) {
+  std::vector<std::string> files;
+  if (!scene_file.contains(Key::Shapes)) return files;
+  for (const auto &shp : scene_file[Key::Shapes])
+    if (shp[Key::Type].get<std::string>() == Val::MeshObj)
+      files.push_back(shp[Key::File].get<std::string>());
+  return files;
+}
+
 bool SceneLoader::reload(const char *path) {
   // Clean.
   // ------
@@ -52,15 +76,29 @@ bool SceneLoader::reload(const char *path) {
   // Check.
   // ------
   m_file_path = std::string(path);
-  std::ifstream f(m_file_path);
-  if (!f) {
-    SError("TRay::scene_from_json: Failed to open scene file " + m_file_path);
-    return false;
-  }
   // Load json.
   // ----------
-  json scene_file = json::parse(f);
-  f.close();
+  json scene_file;
+  std::string error;
+  SceneFileParser parser;
+  if (!parser.parse(m_file_path, &scene_file, &error)) {
+    SError("TRay::scene_from_json: " + error + " (" + m_file_path + ")");
+    return false;
+  }
+  // Meshes come from the snapshot if it is up to date, else from the files.
+  m_snapshot.close();
+  m_write_snapshot = false;
+  if (scene_file.contains(Key::Snapshot) &&
+      scene_file[Key::Snapshot].get<bool>()) {
+    m_snapshot_key =
+        SceneSnapshot::key(parser.world_hash(), referenced_files(scene_file));
+    m_write_snapshot = !m_snapshot.open(m_file_path, m_snapshot_key);
+  }
+  if (!m_snapshot.is_open() &&
+      !parser.read_inline_meshes(&m_inline_meshes, &error)) {
+    SError("TRay::scene_from_json: " + error + " (" + m_file_path + ")");
+    return false;
+  }
   if (!scene_file.is_object()) {
     SError("TRay::scene_from_json: Not an object in scene file" + m_file_path);
     return false;
@@ -83,7 +121,35 @@ bool SceneLoader::reload(const char *path) {
   stat = stat && do_camera(scene_file[Key::Camera]);
   stat = stat && do_sampler(scene_file[Key::Sampler]);
   stat = stat && do_integrator(scene_file[Key::Integrator]);
+  if (stat && m_sample_parts > 1 &&
+      !m_integrator->set_sample_part(m_sample_part, m_sample_parts)) {
+    SError("TRay::scene_from_json: Integrator cannot render part of the "
+           "samples (" + m_file_path + ")");
+    return false;
+  }
+  // Film checkpoints, restarted whenever the scene, a mesh file or the
+  // blue-noise mask changes.
+  const json &film_file = scene_file[Key::Camera][Key::Film];
+  if (stat && film_file.contains(Key::Checkpoint)) {
+    std::vector<std::string> files = referenced_files(scene_file);
+    files.push_back(m_file_path);
+    const json &sampler_file = scene_file[Key::Sampler];
+    if (sampler_file.contains(Key::BlueNoise))
+      files.push_back(sampler_file[Key::BlueNoise].get<std::string>());
+    std::string checkpoint_path = m_camera->m_film->m_filename;
+    if (m_sample_parts > 1)
+      checkpoint_path += string_format(".%d", m_sample_part);
+    m_integrator->set_checkpoint(std::make_shared<FilmCheckpoint>(
+        checkpoint_path + ".ckpt",
+        film_file[Key::Checkpoint].get<Float>(),
+        SceneSnapshot::key(parser.world_hash(), files)));
+  }
 
+  if (stat && m_write_snapshot)
+    SceneSnapshot::write(m_file_path, m_snapshot_key, m_snapshot_owners,
+                         m_snapshot_meshes);
+  m_snapshot_owners.clear();
+  m_snapshot_meshes.clear();
   return true;
 }
 
@@ -242,7 +308,53 @@ bool SceneLoader::do_materials(const json &scene_file) {
 }
 bool SceneLoader::do_shapes(const json &scene_file) {
   SInfo("Loading shapes");
+  using Build = std::function<bool(VEC_OF_SHARED(Shape) *,
+                                   std::vector<MeshData> *)>;
+  // Shapes are read from the json in order, built concurrently, then
+  // committed in order so that named lookups do not depend on timing.
+  struct ShapeJob {
+    std::string name;
+    uint32_t index;
+    // A mesh file replaces an earlier shape of the same name, the others
+    // append to it.
+    bool replace;
+    // Given a vector to keep the meshes in when a snapshot is written.
+    Build build;
+    std::string error = "";
+    std::vector<std::shared_ptr<Shape>> result = {};
+    std::vector<MeshData> meshes = {};
+    bool ok = false;
+    double ms = 0;
+  };
+  std::vector<ShapeJob> jobs;
+  // Snapshot meshes of each shape.
+  std::vector<std::vector<int>> snapshot_meshes(
+      scene_file.contains(Key::Shapes) ? scene_file[Key::Shapes].size() : 0);
+  for (int i = 0; i < m_snapshot.n_shapes(); i++)
+    if (m_snapshot.owner(i) < snapshot_meshes.size())
+      snapshot_meshes[m_snapshot.owner(i)].push_back(i);
+  auto from_snapshot = [this](const Transform &trans, bool flip,
+                              const std::vector<int> &ids) -> Build {
+    return [this, trans, flip, ids](VEC_OF_SHARED(Shape) * out,
+                                    std::vector<MeshData> *) {
+      for (int i : ids) {
+        const MeshCacheShape &shape = m_snapshot.shape(i);
+        auto triangles = create_triangle_mesh(
+            trans, trans.inverse(), flip, int(shape.n_triangles),
+            m_snapshot.indices(i), int(shape.n_vertices),
+            m_snapshot.vertices(i), m_snapshot.normals(i), m_snapshot.uvs(i));
+        out->insert(out->end(), triangles.begin(), triangles.end());
+      }
+      return true;
+    };
+  };
+  uint32_t shape_index = 0;
   for (const auto &shp : scene_file[Key::Shapes]) {
+    // Arrays diverted by the parser, if any.
+    MeshData *inline_mesh = shape_index < m_inline_meshes.size()
+                                ? &m_inline_meshes[shape_index]
+                                : nullptr;
+    uint32_t index = shape_index++;
     std::string name = shp[Key::Name].get<std::string>();
     std::string tp = shp[Key::Type].get<std::string>();
     if (tp == Val::Sphere) {
@@ -250,11 +362,12 @@ bool SceneLoader::do_shapes(const json &scene_file) {
       std::shared_ptr<Transform> trans = transforms[trans_name];
       bool flip = shp[Key::FlipNormal].get<bool>();
       Float radius = shp[Key::Radius].get<Float>();
-      if (shapes.find(name) == shapes.end())
-        shapes[name] = std::make_shared<VEC_OF_SHARED(Shape)>();
-      shapes[name]->push_back(std::make_shared<Sphere>(
-          Sphere{*trans, trans->inverse(), flip, radius}));
-      SInfo("\tGot Shape " + name);
+      jobs.push_back({name, index, false,
+                      [=](VEC_OF_SHARED(Shape) * out, std::vector<MeshData> *) {
+                        out->push_back(std::make_shared<Sphere>(
+                            Sphere{*trans, trans->inverse(), flip, radius}));
+                        return true;
+                      }});
       // SInfo("\tGot Shape " + name + " with:\n\ttype " + tp + "\n\tradius " +
       //       string_format("%f ", radius));
     } else if (tp == Val::MeshPlain) {
@@ -266,30 +379,38 @@ bool SceneLoader::do_shapes(const json &scene_file) {
         trans = trans * (*transs);
       }
       bool flip = shp[Key::FlipNormal].get<bool>();
-      int n_triangles = 0, n_vertices = 0;
-      std::vector<int> vertex_indices;
-      std::vector<Point3f> vertices;
+      if (m_snapshot.is_open()) {
+        jobs.push_back({name, index, false,
+                        from_snapshot(trans, flip, snapshot_meshes[index])});
+        continue;
+      }
+      auto mesh = std::make_shared<MeshData>();
+      if (inline_mesh) *mesh = std::move(*inline_mesh);
       for (const auto &v : shp[Key::Vertex]) {
         Float x = 0, y = 0, z = 0;
         get_float(v, &x, &y, &z);
-        vertices.push_back({x, y, z});
-        n_vertices++;
+        mesh->vertices.push_back({x, y, z});
       }
       for (const auto &i : shp[Key::Index]) {
         int idx = 0;
         idx = i.get<int>();
-        vertex_indices.push_back(idx);
-        n_triangles++;
+        mesh->indices.push_back(idx);
       }
-      n_triangles /= 3;
-      std::vector<std::shared_ptr<Shape>> triangles =
-          create_triangle_mesh(trans, trans.inverse(), flip, n_triangles,
-                               &vertex_indices[0], n_vertices, &vertices[0]);
-      if (shapes.find(name) == shapes.end())
-        shapes[name] = std::make_shared<VEC_OF_SHARED(Shape)>();
-      auto &vec = shapes[name];
-      for (const auto &tri : triangles) vec->push_back(tri);
-      SInfo("\tGot Shape " + name);
+      MeshOrder order = mesh_order(shp);
+      jobs.push_back({name, index, false,
+                      [=](VEC_OF_SHARED(Shape) * out,
+                          std::vector<MeshData> *keep) {
+                        compact_mesh(mesh.get());
+                        reorder_mesh(mesh.get(), order);
+                        *out = create_triangle_mesh(
+                            trans, trans.inverse(), flip, mesh->n_triangles(),
+                            mesh->indices.data(), mesh->n_vertices(),
+                            mesh->vertices.data());
+                        // Done with it, free it early.
+                        if (keep) keep->push_back(std::move(*mesh));
+                        *mesh = MeshData();
+                        return true;
+                      }});
       // SInfo("\tGot Shape " + name + " with:\n\ttype " + tp +
       //       "\n\tnumber of triangles " + string_format("%d ", n_triangles) +
       //       "\n\tnumber of vertices " + string_format("%d ", n_vertices));
@@ -303,22 +424,71 @@ bool SceneLoader::do_shapes(const json &scene_file) {
       }
       bool flip = shp[Key::FlipNormal].get<bool>();
       std::string file_path = shp[Key::File].get<std::string>();
-      std::vector<std::shared_ptr<Shape>> triangles;
-      bool stat =
-          load_triangle_mesh(trans, flip, &triangles, file_path.c_str(), "");
-      if (stat) {
-        shapes[name] = std::make_shared<VEC_OF_SHARED(Shape)>(triangles);
-        SInfo("\tGot Shape " + name);
-        // SInfo("\tGot Shape " + name + " with:\n\ttype " + tp);
-      } else {
-        SError("Error loading triangle mesh from " + file_path);
-        return stat;
+      if (m_snapshot.is_open()) {
+        jobs.push_back({name, index, true,
+                        from_snapshot(trans, flip, snapshot_meshes[index])});
+        continue;
       }
+      bool cache = !shp.contains(Key::Cache) || shp[Key::Cache].get<bool>();
+      MeshOrder order = mesh_order(shp);
+      jobs.push_back(
+          {name, index, true,
+           [=](VEC_OF_SHARED(Shape) * out, std::vector<MeshData> *keep) {
+             if (!keep)
+               return load_triangle_mesh(trans, flip, out, file_path.c_str(),
+                                         "", order, cache);
+             if (!load_mesh_data(file_path.c_str(), order, cache, keep))
+               return false;
+             for (const MeshData &mesh : *keep) {
+               auto triangles = create_triangle_mesh(
+                   trans, trans.inverse(), flip, mesh.n_triangles(),
+                   mesh.indices.data(), mesh.n_vertices(),
+                   mesh.vertices.data(),
+                   mesh.normals.empty() ? nullptr : mesh.normals.data(),
+                   mesh.uvs.empty() ? nullptr : mesh.uvs.data());
+               out->insert(out->end(), triangles.begin(), triangles.end());
+             }
+             return true;
+           },
+           "Error loading triangle mesh from " + file_path});
+      // SInfo("\tGot Shape " + name + " with:\n\ttype " + tp);
     } else {
       SWarn("Unknown Shape type " + tp);
     }
   }
-  SInfo("Shapes loaded");
+  // Build.
+  auto start = std::chrono::steady_clock::now();
+  parallel_for(int64_t(jobs.size()), [&](int64_t i) {
+    ShapeJob &job = jobs[i];
+    auto job_start = std::chrono::steady_clock::now();
+    job.ok = job.build(&job.result, m_write_snapshot ? &job.meshes : nullptr);
+    job.ms = std::chrono::duration<double, std::milli>(
+                 std::chrono::steady_clock::now() - job_start)
+                 .count();
+  });
+  double ms = std::chrono::duration<double, std::milli>(
+                  std::chrono::steady_clock::now() - start)
+                  .count();
+  // Commit.
+  m_inline_meshes.clear();
+  m_snapshot.close();
+  for (ShapeJob &job : jobs) {
+    if (!job.ok) {
+      SError(job.error);
+      return false;
+    }
+    auto &vec = shapes[job.name];
+    if (!vec || job.replace)
+      vec = std::make_shared<VEC_OF_SHARED(Shape)>(std::move(job.result));
+    else
+      vec->insert(vec->end(), job.result.begin(), job.result.end());
+    for (MeshData &mesh : job.meshes) {
+      m_snapshot_owners.push_back(job.index);
+      m_snapshot_meshes.push_back(std::move(mesh));
+    }
+    SInfo(string_format("\tGot Shape %s (%.1f ms)", job.name.c_str(), job.ms));
+  }
+  SInfo(string_format("Shapes loaded in %.1f ms", ms));
   return true;
 }
 bool SceneLoader::do_lights(const json &scene_file) {
@@ -514,12 +684,15 @@ bool SceneLoader::do_sampler(const json &sampler_file) {
   } else if (sam_type == Val::HaltonSampler) {
     Float spp = 0;
     get_float(sampler_file[Key::SamplePerPixel], &spp);
+    bool scramble = sampler_file.contains(Key::Scramble) &&
+                    sampler_file[Key::Scramble].get<bool>();
     m_sampler = std::make_shared<HaltonSampler>(
-        HaltonSampler{int(spp), m_camera->m_film->sample_bound()});
+        HaltonSampler{int(spp), m_camera->m_film->sample_bound(), scramble});
     SInfo(
         string_format("\tGot HaltonSampler with:"
-                      "\n\tspp %d",
-                      int(spp)));
+                      "\n\tspp %d"
+                      "\n\tscramble %d",
+                      int(spp), scramble));
   } else if (sam_type == Val::ZeroTwoSampler) {
     Float spp = 0, sdim = 0;
     get_float(sampler_file[Key::SamplePerPixel], &spp);
@@ -551,10 +724,26 @@ bool SceneLoader::do_sampler(const json &sampler_file) {
         string_format("\tGot SobolSampler with:"
                       "\n\tspp %d",
                       int(spp)));
+  } else if (sam_type == Val::ZSobolSampler) {
+    Float spp = 0;
+    get_float(sampler_file[Key::SamplePerPixel], &spp);
+    m_sampler = std::make_shared<ZSobolSampler>(
+        ZSobolSampler{int(spp), m_camera->m_film->sample_bound()});
+    SInfo(
+        string_format("\tGot ZSobolSampler with:"
+                      "\n\tspp %d",
+                      int(spp)));
   } else {
     SWarn("Unknown Sampler type " + sam_type);
     return false;
   }
+  if (sampler_file.contains(Key::BlueNoise)) {
+    std::string mask_path = sampler_file[Key::BlueNoise].get<std::string>();
+    auto mask = BlueNoiseMask::load(mask_path);
+    if (!mask) return false;
+    m_sampler->set_blue_noise(mask);
+    SInfo("\tDithered by blue noise " + mask_path);
+  }
   SInfo("Sampler loaded");
   return true;
 }
@@ -0,0 +1,252 @@
+#include "loaders/meshcache.h"
+
+#include <cstring>
+#include <limits>
+
+#include "core/geometry/Normal.h"
+#include "core/geometry/Point.h"
+
+#ifdef TRAY_ON_WINDOWS
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace TRay {
+static const char kMeshCacheMagic[4] = {'T', 'R', 'M', 'C'};
+static constexpr uint32_t kMeshCacheVersion = 2;
+static constexpr uint64_t kMeshCacheAlign = 16;
+
+bool MappedFile::open(const std::string &path) {
+  close();
+#ifdef TRAY_ON_WINDOWS
+  HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                            nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL,
+                            nullptr);
+  if (file == INVALID_HANDLE_VALUE) return false;
+  LARGE_INTEGER size;
+  if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+    CloseHandle(file);
+    return false;
+  }
+  HANDLE mapping =
+      CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  void *view =
+      mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+  if (!view) {
+    if (mapping) CloseHandle(mapping);
+    CloseHandle(file);
+    return false;
+  }
+  m_file = file;
+  m_mapping = mapping;
+  m_data = static_cast<const uint8_t *>(view);
+  m_size = size_t(size.QuadPart);
+#else
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) return false;
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size == 0) {
+    ::close(fd);
+    return false;
+  }
+  void *view = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  // The mapping stays valid after the descriptor is closed.
+  ::close(fd);
+  if (view == MAP_FAILED) return false;
+  m_data = static_cast<const uint8_t *>(view);
+  m_size = size_t(st.st_size);
+#endif
+  return true;
+}
+void MappedFile::close() {
+  if (!m_data) return;
+#ifdef TRAY_ON_WINDOWS
+  UnmapViewOfFile(m_data);
+  CloseHandle(m_mapping);
+  CloseHandle(m_file);
+  m_file = m_mapping = nullptr;
+#else
+  munmap(const_cast<uint8_t *>(m_data), m_size);
+#endif
+  m_data = nullptr;
+  m_size = 0;
+}
+
+/// @brief FNV-1a over the whole file, 0 if it can not be read.
+static uint64_t file_hash(const std::string &path) {
+  MappedFile file;
+  if (!file.open(path)) return 0;
+  uint64_t h = 14695981039346656037ull;
+  for (size_t i = 0; i < file.size(); i++) {
+    h ^= file.data()[i];
+    h *= 1099511628211ull;
+  }
+  return h;
+}
+static uint64_t align_block(uint64_t v) {
+  return (v + kMeshCacheAlign - 1) / kMeshCacheAlign * kMeshCacheAlign;
+}
+bool MeshBlocks::view(const MappedFile &file, uint64_t table_offset,
+                      uint32_t n_shapes) {
+  clear_view();
+  size_t size = file.size();
+  if (size < table_offset + uint64_t(n_shapes) * sizeof(MeshCacheShape))
+    return false;
+  const MeshCacheShape *shapes =
+      reinterpret_cast<const MeshCacheShape *>(file.data() + table_offset);
+  auto inside = [&](uint64_t offset, uint64_t bytes) {
+    return offset % kMeshCacheAlign == 0 && offset + bytes <= size;
+  };
+  for (uint32_t i = 0; i < n_shapes; i++) {
+    const MeshCacheShape &s = shapes[i];
+    if (!inside(s.vertices_offset, uint64_t(s.n_vertices) * sizeof(Point3f)) ||
+        !inside(s.indices_offset, uint64_t(s.n_triangles) * 3 * sizeof(int)) ||
+        (s.has_normals &&
+         !inside(s.normals_offset, uint64_t(s.n_vertices) * sizeof(Normal3f))) ||
+        (s.has_uvs &&
+         !inside(s.uvs_offset, uint64_t(s.n_vertices) * sizeof(Point2f))))
+      return false;
+    // TriangleMesh takes the indices as they are, 16 bits wide for small
+    // meshes.
+    if (s.n_vertices > uint32_t(std::numeric_limits<int>::max())) return false;
+    const int *indices =
+        reinterpret_cast<const int *>(file.data() + s.indices_offset);
+    for (uint64_t k = 0; k < uint64_t(s.n_triangles) * 3; k++)
+      if (indices[k] < 0 || uint32_t(indices[k]) >= s.n_vertices) return false;
+  }
+  m_data = file.data();
+  m_shapes = shapes;
+  m_n_shapes = n_shapes;
+  return true;
+}
+void MeshBlocks::clear_view() {
+  m_data = nullptr;
+  m_shapes = nullptr;
+  m_n_shapes = 0;
+}
+const Point3f *MeshBlocks::vertices(int i) const {
+  return at<Point3f>(m_shapes[i].vertices_offset);
+}
+const Normal3f *MeshBlocks::normals(int i) const {
+  return m_shapes[i].has_normals ? at<Normal3f>(m_shapes[i].normals_offset)
+                                 : nullptr;
+}
+const Point2f *MeshBlocks::uvs(int i) const {
+  return m_shapes[i].has_uvs ? at<Point2f>(m_shapes[i].uvs_offset) : nullptr;
+}
+const int *MeshBlocks::indices(int i) const {
+  return at<int>(m_shapes[i].indices_offset);
+}
+uint64_t MeshBlocks::layout(const std::vector<MeshData> &meshes,
+                            uint64_t table_offset,
+                            std::vector<MeshCacheShape> *table) {
+  table->resize(meshes.size());
+  uint64_t offset =
+      align_block(table_offset + meshes.size() * sizeof(MeshCacheShape));
+  for (size_t i = 0; i < meshes.size(); i++) {
+    const MeshData &mesh = meshes[i];
+    MeshCacheShape &s = (*table)[i];
+    memset(&s, 0, sizeof(s));
+    s.n_vertices = uint32_t(mesh.n_vertices());
+    s.n_triangles = uint32_t(mesh.n_triangles());
+    s.has_normals = !mesh.normals.empty();
+    s.has_uvs = !mesh.uvs.empty();
+    s.vertices_offset = offset;
+    offset = align_block(offset + mesh.vertices.size() * sizeof(Point3f));
+    if (s.has_normals) {
+      s.normals_offset = offset;
+      offset = align_block(offset + mesh.normals.size() * sizeof(Normal3f));
+    }
+    if (s.has_uvs) {
+      s.uvs_offset = offset;
+      offset = align_block(offset + mesh.uvs.size() * sizeof(Point2f));
+    }
+    s.indices_offset = offset;
+    offset = align_block(offset + mesh.indices.size() * sizeof(int));
+  }
+  return offset;
+}
+void MeshBlocks::fill(const std::vector<MeshData> &meshes,
+                      uint64_t table_offset,
+                      const std::vector<MeshCacheShape> &table,
+                      uint8_t *image) {
+  auto put = [&](uint64_t at, const void *src, size_t bytes) {
+    if (bytes) memcpy(image + at, src, bytes);
+  };
+  put(table_offset, table.data(), table.size() * sizeof(MeshCacheShape));
+  for (size_t i = 0; i < meshes.size(); i++) {
+    const MeshData &mesh = meshes[i];
+    const MeshCacheShape &s = table[i];
+    put(s.vertices_offset, mesh.vertices.data(),
+        mesh.vertices.size() * sizeof(Point3f));
+    put(s.normals_offset, mesh.normals.data(),
+        mesh.normals.size() * sizeof(Normal3f));
+    put(s.uvs_offset, mesh.uvs.data(), mesh.uvs.size() * sizeof(Point2f));
+    put(s.indices_offset, mesh.indices.data(),
+        mesh.indices.size() * sizeof(int));
+  }
+}
+
+std::string MeshCache::cache_path(const std::string &source_path) {
+  return source_path + ".trmesh";
+}
+bool MeshCache::open(const std::string &source_path, MeshOrder order) {
+  clear_view();
+  uint64_t size;
+  int64_t mtime;
+  if (!file_identity(source_path, &size, &mtime)) return false;
+  if (!m_file.open(cache_path(source_path))) return false;
+  // Validate everything before handing out pointers.
+  auto fail = [&](const std::string &why) {
+    SInfo("MeshCache:: Ignoring cache of " + source_path + ", " + why);
+    m_file.close();
+    return false;
+  };
+  if (m_file.size() < sizeof(MeshCacheHeader)) return fail("truncated");
+  const MeshCacheHeader *header =
+      reinterpret_cast<const MeshCacheHeader *>(m_file.data());
+  if (memcmp(header->magic, kMeshCacheMagic, 4) != 0 ||
+      header->version != kMeshCacheVersion ||
+      header->float_size != sizeof(Float))
+    return fail("different format");
+  if (header->order != uint32_t(order)) return fail("different order");
+  if (header->source_size != size) return fail("source changed");
+  // A new mtime with the same content, e.g. after a checkout, is fine.
+  if (header->source_mtime != mtime &&
+      header->source_hash != file_hash(source_path))
+    return fail("source changed");
+  if (!view(m_file, sizeof(MeshCacheHeader), header->n_shapes))
+    return fail("truncated");
+  return true;
+}
+
+bool MeshCache::write(const std::string &source_path, MeshOrder order,
+                      const std::vector<MeshData> &meshes) {
+  MeshCacheHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, kMeshCacheMagic, 4);
+  header.version = kMeshCacheVersion;
+  header.float_size = sizeof(Float);
+  header.order = uint32_t(order);
+  header.n_shapes = uint32_t(meshes.size());
+  if (!file_identity(source_path, &header.source_size, &header.source_mtime))
+    return false;
+  header.source_hash = file_hash(source_path);
+  std::vector<MeshCacheShape> table;
+  uint64_t size = MeshBlocks::layout(meshes, sizeof(header), &table);
+  std::vector<uint8_t> image(size, 0);
+  memcpy(image.data(), &header, sizeof(header));
+  MeshBlocks::fill(meshes, sizeof(header), table, image.data());
+  std::string path = cache_path(source_path);
+  if (!write_file_replacing(path, image.data(), image.size())) return false;
+  SInfo("MeshCache:: Wrote " + path);
+  return true;
+}
+}  // namespace TRay
\ No newline at end of file
@@ -1,77 +1,139 @@
-#define TINYOBJLOADER_IMPLEMENTATION
-#include "tiny_obj_loader.h"
 #include "core/geometry/Point.h"
+#include "loaders/meshcache.h"
 #include "loaders/meshloading.h"
+#include "loaders/meshprocessing.h"
+#include "loaders/objparser.h"
 #include "shapes/TriangleMesh.h"
 
 namespace TRay {
-bool load_triangle_mesh(const Transform& obj_to_world, bool flip_normal,
-                        std::vector<std::shared_ptr<Shape>>* triangles,
-                        const char* filename, const char* basepath) {
-  SInfo("Loading triangle mesh from file " + std::string(filename) +
-        ", base dir " + std::string(basepath));
-  // Load from file.
-  tinyobj::attrib_t attrib;
-  std::vector<tinyobj::shape_t> shapes;
-  std::vector<tinyobj::material_t> materials;
-  std::string warn;
+/// @brief @param idx of @param n corners, if it is set and every corner has
+///        an attribute.
+static bool all_corners_set(const std::vector<int>& idx, size_t first,
+                            int n) {
+  if (idx.empty()) return false;
+  for (int k = 0; k < n; k++)
+    if (idx[first + k] < 0) return false;
+  return true;
+}
+/// @brief Parse @param filename into one compacted and ordered MeshData for
+///        each shape.
+static bool load_obj_meshes(const char* filename, MeshOrder order,
+                            std::vector<MeshData>* meshes) {
+  ObjData obj;
   std::string err;
-  bool ret = tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err,
-                              filename, basepath, true);
-  if (!warn.empty()) SWarn("Warn loading triangle mesh: " + warn);
-  if (!err.empty()) SError("Error loading triangle mesh: " + err);
-  if (!ret) {
-    printf("Failed to load/parse .obj.\n");
+  if (!parse_obj(filename, &obj, &err)) {
+    SError("Error loading triangle mesh: " + err);
     SError("Failed loading triangle mesh from " + std::string(filename));
     return false;
   }
   // Dump into TRay format.
-  // NOTE Maybe redundant for multiple shapes,
-  // since TriangleMesh keeps a copy of vertices.
-  std::vector<Point3f> total_vertices;
-  SInfo(
-      string_format("%d vertices in total.", int(attrib.vertices.size() / 3)));
-  for (size_t vi = 0; vi < attrib.vertices.size() / 3; vi++) {
-    total_vertices.push_back({attrib.vertices[3 * vi + 0],
-                              attrib.vertices[3 * vi + 1],
-                              attrib.vertices[3 * vi + 2]});
-  }
-  for (size_t si = 0; si < shapes.size(); si++) {
+  // Each shape gets its own vertex set, unused vertices of the shared pool
+  // are stripped and duplicates are welded.
+  SInfo(string_format("%d vertices in total.", int(obj.vertices.size())));
+  meshes->resize(obj.shapes.size());
+  for (size_t si = 0; si < obj.shapes.size(); si++) {
+    const ObjShape& shape = obj.shapes[si];
     SInfo(string_format("Processing shape %d (name \"%s\")...", int(si),
-                        shapes[si].name.c_str()));
-    int n_triangles = 0, n_vertices = 0;
-    std::vector<int> vertex_indices;
-    n_triangles = shapes[si].mesh.num_face_vertices.size();
-    n_vertices = total_vertices.size();
-
-    size_t idx_offset = 0;
-    for (size_t fi = 0; fi < shapes[si].mesh.num_face_vertices.size(); fi++) {
-      size_t vnum = shapes[si].mesh.num_face_vertices[fi];
-      // SInfo(string_format("face %d, num vertices %d", int(fi), int(vnum)));
-      for (size_t vi = 0; vi < vnum; vi++) {
-        tinyobj::index_t idx = shapes[si].mesh.indices[idx_offset + vi];
-        vertex_indices.push_back(idx.vertex_index);
+                        shape.name.c_str()));
+    MeshData& mesh = (*meshes)[si];
+    size_t first = 3 * shape.first_triangle;
+    int n = int(3 * shape.n_triangles);
+    const int* vi = obj.vertex_indices.data() + first;
+    // A shape keeps normals or uvs only if all of its corners have them.
+    bool has_normals = all_corners_set(obj.normal_indices, first, n);
+    bool has_uvs = all_corners_set(obj.uv_indices, first, n);
+    if (!has_normals && !has_uvs) {
+      compact_mesh(obj.vertices.data(), nullptr, nullptr, vi, n, &mesh);
+    } else {
+      // Normals and uvs index pools of their own, gather every corner and
+      // let the welding merge the corners with the same attributes.
+      std::vector<Point3f> p(n);
+      std::vector<Normal3f> normals(has_normals ? n : 0);
+      std::vector<Point2f> uvs(has_uvs ? n : 0);
+      std::vector<int> corners(n);
+      for (int k = 0; k < n; k++) {
+        p[k] = obj.vertices[vi[k]];
+        if (has_normals)
+          normals[k] = obj.normals[obj.normal_indices[first + k]];
+        if (has_uvs) uvs[k] = obj.uvs[obj.uv_indices[first + k]];
+        corners[k] = k;
       }
-      // SInfo("------------");
-      idx_offset += vnum;
+      compact_mesh(p.data(), has_normals ? normals.data() : nullptr,
+                   has_uvs ? uvs.data() : nullptr, corners.data(), n, &mesh);
+    }
+    reorder_mesh(&mesh, order);
+  }
+  return true;
+}
+
+/// @brief Parse @param filename and write its cache if @param use_cache.
+static bool load_and_cache(const char* filename, MeshOrder order,
+                           bool use_cache, std::vector<MeshData>* meshes) {
+  if (!load_obj_meshes(filename, order, meshes)) return false;
+  if (use_cache) MeshCache::write(filename, order, *meshes);
+  return true;
+}
+
+bool load_mesh_data(const char* filename, MeshOrder order, bool use_cache,
+                    std::vector<MeshData>* meshes) {
+  MeshCache cache;
+  if (use_cache && cache.open(filename, order)) {
+    meshes->resize(cache.n_shapes());
+    for (int si = 0; si < cache.n_shapes(); si++) {
+      const MeshCacheShape& shape = cache.shape(si);
+      MeshData& mesh = (*meshes)[si];
+      mesh.vertices.assign(cache.vertices(si),
+                           cache.vertices(si) + shape.n_vertices);
+      if (shape.has_normals)
+        mesh.normals.assign(cache.normals(si),
+                            cache.normals(si) + shape.n_vertices);
+      if (shape.has_uvs)
+        mesh.uvs.assign(cache.uvs(si), cache.uvs(si) + shape.n_vertices);
+      mesh.indices.assign(cache.indices(si),
+                          cache.indices(si) + 3 * shape.n_triangles);
     }
-    /**
-     * input
-     *   const Transform &obj_world, const Transform &world_obj,
-     *   bool flip_normal,
-     *   int n_triangles, const int *vertex_indices,
-     *   int n_vertices, const Point3f *vertices,
-     *
-     * output
-     *   std::vector<std::shared_ptr<Shape>>
-     */
+    SInfo("Loaded triangle mesh from cache " +
+          MeshCache::cache_path(filename));
+    return true;
+  }
+  return load_and_cache(filename, order, use_cache, meshes);
+}
+bool load_triangle_mesh(const Transform& obj_to_world, bool flip_normal,
+                        std::vector<std::shared_ptr<Shape>>* triangles,
+                        const char* filename, const char* basepath,
+                        MeshOrder order, bool use_cache) {
+  SInfo("Loading triangle mesh from file " + std::string(filename) +
+        ", base dir " + std::string(basepath));
+  Transform world_to_obj = obj_to_world.inverse();
+  auto add_mesh = [&](int n_triangles, const int* indices, int n_vertices,
+                      const Point3f* vertices, const Normal3f* normals,
+                      const Point2f* uvs) {
     auto triangle_vec = create_triangle_mesh(
-        obj_to_world, obj_to_world.inverse(), flip_normal, n_triangles,
-        &vertex_indices[0], n_vertices, &total_vertices[0]);
+        obj_to_world, world_to_obj, flip_normal, n_triangles, indices,
+        n_vertices, vertices, normals, uvs);
     triangles->insert(triangles->end(), triangle_vec.begin(),
                       triangle_vec.end());
+  };
+  // The meshes are built from the mapped cache as it is.
+  MeshCache cache;
+  if (use_cache && cache.open(filename, order)) {
+    for (int si = 0; si < cache.n_shapes(); si++) {
+      const MeshCacheShape& shape = cache.shape(si);
+      add_mesh(int(shape.n_triangles), cache.indices(si),
+               int(shape.n_vertices), cache.vertices(si), cache.normals(si),
+               cache.uvs(si));
+    }
+    SInfo("Loaded triangle mesh from cache " +
+          MeshCache::cache_path(filename));
+  } else {
+    std::vector<MeshData> meshes;
+    if (!load_and_cache(filename, order, use_cache, &meshes)) return false;
+    for (const MeshData& mesh : meshes)
+      add_mesh(mesh.n_triangles(), mesh.indices.data(), mesh.n_vertices(),
+               mesh.vertices.data(),
+               mesh.normals.empty() ? nullptr : mesh.normals.data(),
+               mesh.uvs.empty() ? nullptr : mesh.uvs.data());
   }
-
   SInfo("Loaded triangle mesh from file " + std::string(filename) +
         ", base dir " + std::string(basepath));
   return true;
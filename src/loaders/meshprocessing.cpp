@@ -0,0 +1,271 @@
+#include "loaders/meshprocessing.h"
+
+#include <algorithm>
+#include <numeric>
+#include <unordered_map>
+
+#include "core/geometry/Bound.h"
+
+namespace TRay {
+namespace {
+/// @brief All attributes of one vertex, used as the welding key.
+struct VertexKey {
+  Point3f p;
+  Normal3f n;
+  Point2f uv;
+  bool operator==(const VertexKey &o) const {
+    return p == o.p && n == o.n && uv == o.uv;
+  }
+};
+struct VertexKeyHash {
+  size_t operator()(const VertexKey &k) const {
+    // Adding zero folds -0 into +0, which compare equal.
+    const Float v[8] = {k.p.x + 0,  k.p.y + 0,  k.p.z + 0, k.n.x + 0,
+                        k.n.y + 0,  k.n.z + 0,  k.uv.x + 0, k.uv.y + 0};
+    size_t h = 0;
+    for (Float f : v)
+      h ^= std::hash<Float>()(f) + 0x9e3779b9 + (h << 6) + (h >> 2);
+    return h;
+  }
+};
+
+/// @brief Spread the lower 10 bits of @param v to every third bit.
+inline uint32_t left_shift3(uint32_t v) {
+  v &= 0x3ff;
+  v = (v | (v << 16)) & 0x030000ff;
+  v = (v | (v << 8)) & 0x0300f00f;
+  v = (v | (v << 4)) & 0x030c30c3;
+  v = (v | (v << 2)) & 0x09249249;
+  return v;
+}
+/// @brief 30-bit Morton code of a point inside @param bound.
+inline uint32_t morton_code(const Point3f &p, const Bound3f &bound) {
+  Vector3f off = p - bound.p_min, extent = bound.diagonal();
+  // Flat meshes have zero extent on some axis.
+  auto quantize = [](Float v, Float ext) {
+    return ext > 0 ? (uint32_t)clamp(v / ext * 1024, 0, 1023) : 0u;
+  };
+  return (left_shift3(quantize(off.z, extent.z)) << 2) |
+         (left_shift3(quantize(off.y, extent.y)) << 1) |
+         left_shift3(quantize(off.x, extent.x));
+}
+
+/// @brief Apply a new vertex order. @param order[new_idx] = old_idx.
+void permute_vertices(MeshData *mesh, const std::vector<int> &order) {
+  int nv = mesh->n_vertices();
+  std::vector<int> remap(nv);
+  for (int i = 0; i < nv; i++) remap[order[i]] = i;
+  std::vector<Point3f> vertices(nv);
+  for (int i = 0; i < nv; i++) vertices[i] = mesh->vertices[order[i]];
+  mesh->vertices.swap(vertices);
+  if (!mesh->normals.empty()) {
+    std::vector<Normal3f> normals(nv);
+    for (int i = 0; i < nv; i++) normals[i] = mesh->normals[order[i]];
+    mesh->normals.swap(normals);
+  }
+  if (!mesh->uvs.empty()) {
+    std::vector<Point2f> uvs(nv);
+    for (int i = 0; i < nv; i++) uvs[i] = mesh->uvs[order[i]];
+    mesh->uvs.swap(uvs);
+  }
+  for (int &idx : mesh->indices) idx = remap[idx];
+}
+/// @brief Apply a new triangle order. @param order[new_tri] = old_tri.
+void permute_triangles(MeshData *mesh, const std::vector<int> &order) {
+  std::vector<int> indices(mesh->indices.size());
+  for (size_t t = 0; t < order.size(); t++)
+    for (int k = 0; k < 3; k++)
+      indices[3 * t + k] = mesh->indices[3 * order[t] + k];
+  mesh->indices.swap(indices);
+}
+/// @brief Vertices in the order the triangles first reference them.
+void order_vertices_by_first_use(MeshData *mesh) {
+  int nv = mesh->n_vertices();
+  std::vector<int> order;
+  std::vector<bool> visited(nv, false);
+  order.reserve(nv);
+  for (int idx : mesh->indices) {
+    if (visited[idx]) continue;
+    visited[idx] = true;
+    order.push_back(idx);
+  }
+  permute_vertices(mesh, order);
+}
+
+void reorder_morton(MeshData *mesh) {
+  int nv = mesh->n_vertices(), nt = mesh->n_triangles();
+  Bound3f bound;
+  for (const Point3f &p : mesh->vertices) bound = bound_insert(bound, p);
+  // Vertices first, then triangles by their centroids.
+  std::vector<uint32_t> codes(nv);
+  for (int i = 0; i < nv; i++)
+    codes[i] = morton_code(mesh->vertices[i], bound);
+  std::vector<int> order(nv);
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(),
+                   [&](int a, int b) { return codes[a] < codes[b]; });
+  permute_vertices(mesh, order);
+
+  codes.resize(nt);
+  for (int t = 0; t < nt; t++) {
+    const Point3f &p0 = mesh->vertices[mesh->indices[3 * t + 0]];
+    const Point3f &p1 = mesh->vertices[mesh->indices[3 * t + 1]];
+    const Point3f &p2 = mesh->vertices[mesh->indices[3 * t + 2]];
+    codes[t] = morton_code((p0 + p1 + p2) * (Float(1) / 3), bound);
+  }
+  order.resize(nt);
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(),
+                   [&](int a, int b) { return codes[a] < codes[b]; });
+  permute_triangles(mesh, order);
+}
+
+/**
+ * Tom Forsyth, "Linear-Speed Vertex Cache Optimisation", 2006.
+ * Greedily emit the triangle with the highest score, where a vertex scores
+ * higher when it is recently used and has few triangles left.
+ */
+constexpr int kCacheSize = 32;
+float vertex_score(int cache_pos, int n_remaining) {
+  if (n_remaining == 0) return -1.f;
+  float score = 0.f;
+  if (cache_pos >= 0) {
+    if (cache_pos < 3) {
+      // Just used by the last triangle, no gain from using them again.
+      score = 0.75f;
+    } else {
+      const float scaler = 1.f / (kCacheSize - 3);
+      score = std::pow(1.f - (cache_pos - 3) * scaler, 1.5f);
+    }
+  }
+  // Bonus for vertices with few triangles left, to finish them off.
+  score += 2.f / std::sqrt(float(n_remaining));
+  return score;
+}
+void reorder_vertex_cache(MeshData *mesh) {
+  int nv = mesh->n_vertices(), nt = mesh->n_triangles();
+  const std::vector<int> &indices = mesh->indices;
+  // Triangle adjacency of each vertex, in CSR layout.
+  std::vector<int> n_remaining(nv, 0), adj_offset(nv + 1, 0), adj(3 * nt);
+  for (int idx : indices) n_remaining[idx]++;
+  for (int v = 0; v < nv; v++)
+    adj_offset[v + 1] = adj_offset[v] + n_remaining[v];
+  std::vector<int> fill(adj_offset.begin(), adj_offset.end() - 1);
+  for (int t = 0; t < nt; t++)
+    for (int k = 0; k < 3; k++) adj[fill[indices[3 * t + k]]++] = t;
+
+  std::vector<int> cache_pos(nv, -1);
+  std::vector<float> v_score(nv), t_score(nt, 0.f);
+  std::vector<bool> emitted(nt, false);
+  for (int v = 0; v < nv; v++) v_score[v] = vertex_score(-1, n_remaining[v]);
+  for (int t = 0; t < nt; t++)
+    for (int k = 0; k < 3; k++) t_score[t] += v_score[indices[3 * t + k]];
+
+  std::vector<int> cache, order;
+  cache.reserve(kCacheSize + 3);
+  order.reserve(nt);
+  int best = -1, scan_from = 0;
+  while ((int)order.size() < nt) {
+    if (best < 0) {
+      // Nothing in cache to continue with, take the next unused triangle.
+      while (emitted[scan_from]) scan_from++;
+      best = scan_from;
+    }
+    emitted[best] = true;
+    order.push_back(best);
+    // Move its vertices to the front of the LRU cache.
+    for (int k = 2; k >= 0; k--) {
+      int v = indices[3 * best + k];
+      auto it = std::find(cache.begin(), cache.end(), v);
+      if (it != cache.end()) cache.erase(it);
+      cache.insert(cache.begin(), v);
+      // Drop the emitted triangle from the adjacency.
+      // Degenerate triangles may list one vertex twice.
+      int *b = &adj[adj_offset[v]], *e = b + n_remaining[v];
+      int *found = std::find(b, e, best);
+      if (found == e) continue;
+      std::iter_swap(found, e - 1);
+      n_remaining[v]--;
+    }
+    // Rescore the cached vertices, plus the ones falling out.
+    for (size_t i = 0; i < cache.size(); i++) {
+      int v = cache[i];
+      cache_pos[v] = i < (size_t)kCacheSize ? int(i) : -1;
+      float new_score = vertex_score(cache_pos[v], n_remaining[v]);
+      float delta = new_score - v_score[v];
+      v_score[v] = new_score;
+      for (int j = 0; j < n_remaining[v]; j++)
+        t_score[adj[adj_offset[v] + j]] += delta;
+    }
+    if (cache.size() > (size_t)kCacheSize) cache.resize(kCacheSize);
+    // Next candidate from triangles touching the cache.
+    best = -1;
+    float best_score = -1.f;
+    for (int v : cache)
+      for (int j = 0; j < n_remaining[v]; j++) {
+        int t = adj[adj_offset[v] + j];
+        if (t_score[t] > best_score) {
+          best_score = t_score[t];
+          best = t;
+        }
+      }
+  }
+  permute_triangles(mesh, order);
+  order_vertices_by_first_use(mesh);
+}
+}  // namespace
+
+void compact_mesh(const Point3f *vertices, const Normal3f *normals,
+                  const Point2f *uvs, const int *indices, int n_indices,
+                  MeshData *mesh) {
+  MeshData result;
+  result.indices.reserve(n_indices);
+  std::unordered_map<int, int> pool_to_new;
+  std::unordered_map<VertexKey, int, VertexKeyHash> welded;
+  for (int i = 0; i < n_indices; i++) {
+    int idx = indices[i];
+    auto pooled = pool_to_new.find(idx);
+    if (pooled != pool_to_new.end()) {
+      result.indices.push_back(pooled->second);
+      continue;
+    }
+    VertexKey key{vertices[idx], normals ? normals[idx] : Normal3f(),
+                  uvs ? uvs[idx] : Point2f()};
+    auto same = welded.find(key);
+    int new_idx = 0;
+    if (same != welded.end()) {
+      new_idx = same->second;
+    } else {
+      new_idx = result.n_vertices();
+      welded.emplace(key, new_idx);
+      result.vertices.push_back(key.p);
+      if (normals) result.normals.push_back(key.n);
+      if (uvs) result.uvs.push_back(key.uv);
+    }
+    pool_to_new.emplace(idx, new_idx);
+    result.indices.push_back(new_idx);
+  }
+  *mesh = std::move(result);
+}
+void compact_mesh(MeshData *mesh) {
+  MeshData src = std::move(*mesh);
+  compact_mesh(src.vertices.data(),
+               src.normals.empty() ? nullptr : src.normals.data(),
+               src.uvs.empty() ? nullptr : src.uvs.data(), src.indices.data(),
+               int(src.indices.size()), mesh);
+}
+void reorder_mesh(MeshData *mesh, MeshOrder order) {
+  if (mesh->n_triangles() == 0) return;
+  switch (order) {
+    case MeshOrder::Morton:
+      reorder_morton(mesh);
+      break;
+    case MeshOrder::VertexCache:
+      reorder_vertex_cache(mesh);
+      break;
+    case MeshOrder::None:
+    default:
+      break;
+  }
+}
+}  // namespace TRay
\ No newline at end of file
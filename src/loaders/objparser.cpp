@@ -0,0 +1,344 @@
+#include "loaders/objparser.h"
+
+#include <algorithm>
+#include <charconv>
+#include <limits>
+
+#include "core/parallel.h"
+#include "core/stringformat.h"
+#include "loaders/meshcache.h"
+
+namespace TRay {
+namespace {
+/// @brief Chunks smaller than this are not worth a thread.
+constexpr size_t kMinChunkBytes = 1 << 20;
+
+inline bool is_space(char c) { return c == ' ' || c == '\t'; }
+inline bool is_eol(char c) { return c == '\n' || c == '\r'; }
+inline const char *skip_space(const char *p, const char *end) {
+  while (p < end && is_space(*p)) p++;
+  return p;
+}
+inline const char *skip_token(const char *p, const char *end) {
+  while (p < end && !is_space(*p) && !is_eol(*p)) p++;
+  return p;
+}
+inline const char *next_line(const char *p, const char *end) {
+  while (p < end && *p != '\n') p++;
+  return p < end ? p + 1 : end;
+}
+/// @brief Record type, the first token of the line.
+enum class Record { Other, Vertex, Normal, UV, Face, Group, Object };
+inline Record record_type(const char *p, const char *end) {
+  if (p + 1 >= end || !is_space(p[1])) {
+    if (p + 2 < end && p[0] == 'v' && is_space(p[2])) {
+      if (p[1] == 'n') return Record::Normal;
+      if (p[1] == 't') return Record::UV;
+    }
+    return Record::Other;
+  }
+  switch (p[0]) {
+    case 'v':
+      return Record::Vertex;
+    case 'f':
+      return Record::Face;
+    case 'g':
+      return Record::Group;
+    case 'o':
+      return Record::Object;
+    default:
+      return Record::Other;
+  }
+}
+
+/// @brief Parse a float like tinyobj, missing values are 0.
+inline float parse_float(const char **p, const char *end) {
+  const char *s = skip_space(*p, end);
+  // from_chars does not take a leading '+'.
+  if (s < end && *s == '+') s++;
+  float v = 0.f;
+  auto res = std::from_chars(s, end, v);
+  *p = res.ec == std::errc() ? res.ptr : skip_token(s, end);
+  return v;
+}
+inline bool parse_int(const char **p, const char *end, int *v) {
+  auto res = std::from_chars(*p, end, *v);
+  if (res.ec != std::errc()) return false;
+  *p = res.ptr;
+  return true;
+}
+
+/// @brief Record counts of a chunk. After the prefix sum, the counts of all
+///        chunks before it.
+struct ChunkCounts {
+  size_t vertices = 0, normals = 0, uvs = 0, triangles = 0, lines = 0;
+};
+struct Chunk {
+  const char *begin, *end;
+  ChunkCounts count, base;
+  // Second pass output.
+  std::vector<ObjShape> shapes;
+  std::vector<size_t> quads;
+  bool has_normal_refs = false, has_uv_refs = false;
+  std::string error;
+};
+
+void count_chunk(Chunk *chunk) {
+  ChunkCounts &count = chunk->count;
+  for (const char *p = chunk->begin; p < chunk->end;) {
+    const char *line = skip_space(p, chunk->end);
+    p = next_line(line, chunk->end);
+    count.lines++;
+    switch (record_type(line, chunk->end)) {
+      case Record::Vertex:
+        count.vertices++;
+        break;
+      case Record::Normal:
+        count.normals++;
+        break;
+      case Record::UV:
+        count.uvs++;
+        break;
+      case Record::Face: {
+        size_t n = 0;
+        for (const char *q = skip_space(line + 1, p); q < p && !is_eol(*q);
+             q = skip_space(skip_token(q, p), p))
+          n++;
+        if (n >= 3) count.triangles += n - 2;
+        break;
+      }
+      default:
+        break;
+    }
+  }
+}
+
+/// @brief One polygon corner, already 0-based and global.
+struct Corner {
+  int v, vt, vn;
+};
+
+/// @brief OBJ indices are 1-based, negative ones count back from the last
+///        record read so far.
+inline bool fix_index(int idx, size_t n_so_far, size_t n_total, int *out) {
+  if (idx > 0)
+    *out = idx - 1;
+  else if (idx < 0)
+    *out = int(n_so_far) + idx;
+  else
+    return false;
+  return *out >= 0 && size_t(*out) < n_total;
+}
+
+void parse_chunk(Chunk *chunk, const ChunkCounts &total, ObjData *obj) {
+  const char *end = chunk->end;
+  ChunkCounts at = chunk->base;
+  std::vector<Corner> corners;
+  bool with_normals = !obj->normal_indices.empty();
+  bool with_uvs = !obj->uv_indices.empty();
+  auto fail = [&](const char *what) {
+    chunk->error = string_format("%s at line %lld.", what,
+                                 (long long)(at.lines + 1));
+  };
+  for (const char *p = chunk->begin; p < end; at.lines++) {
+    const char *line = skip_space(p, end);
+    p = next_line(line, end);
+    switch (record_type(line, end)) {
+      case Record::Vertex: {
+        const char *q = line + 1;
+        float x = parse_float(&q, p), y = parse_float(&q, p),
+              z = parse_float(&q, p);
+        obj->vertices[at.vertices++] = Point3f(x, y, z);
+        break;
+      }
+      case Record::Normal: {
+        const char *q = line + 2;
+        float x = parse_float(&q, p), y = parse_float(&q, p),
+              z = parse_float(&q, p);
+        obj->normals[at.normals++] = Normal3f(x, y, z);
+        break;
+      }
+      case Record::UV: {
+        const char *q = line + 2;
+        float u = parse_float(&q, p), v = parse_float(&q, p);
+        obj->uvs[at.uvs++] = Point2f(u, v);
+        break;
+      }
+      case Record::Face: {
+        corners.clear();
+        for (const char *q = skip_space(line + 1, p); q < p && !is_eol(*q);
+             q = skip_space(q, p)) {
+          // v, v/vt, v//vn or v/vt/vn.
+          Corner c{-1, -1, -1};
+          int idx;
+          if (!parse_int(&q, p, &idx) ||
+              !fix_index(idx, at.vertices, total.vertices, &c.v))
+            return fail("Invalid vertex index");
+          if (q < p && *q == '/') {
+            q++;
+            if (q < p && *q != '/') {
+              if (!parse_int(&q, p, &idx) ||
+                  !fix_index(idx, at.uvs, total.uvs, &c.vt))
+                return fail("Invalid uv index");
+              chunk->has_uv_refs = true;
+            }
+            if (q < p && *q == '/') {
+              q++;
+              if (!parse_int(&q, p, &idx) ||
+                  !fix_index(idx, at.normals, total.normals, &c.vn))
+                return fail("Invalid normal index");
+              chunk->has_normal_refs = true;
+            }
+          }
+          if (q < p && !is_space(*q) && !is_eol(*q))
+            return fail("Invalid face");
+          corners.push_back(c);
+        }
+        if (corners.size() < 3) break;
+        // Fan, quads are fixed up once all vertices are known.
+        if (corners.size() == 4) chunk->quads.push_back(at.triangles);
+        for (size_t k = 2; k < corners.size(); k++) {
+          const Corner *tri[3] = {&corners[0], &corners[k - 1], &corners[k]};
+          size_t o = 3 * at.triangles++;
+          for (int j = 0; j < 3; j++) {
+            obj->vertex_indices[o + j] = tri[j]->v;
+            if (with_normals) obj->normal_indices[o + j] = tri[j]->vn;
+            if (with_uvs) obj->uv_indices[o + j] = tri[j]->vt;
+          }
+        }
+        break;
+      }
+      case Record::Group: {
+        // Several group names are joined by a space.
+        std::string name;
+        for (const char *q = skip_space(line + 1, p); q < p && !is_eol(*q);) {
+          const char *e = skip_token(q, p);
+          if (!name.empty()) name += ' ';
+          name.append(q, e);
+          q = skip_space(e, p);
+        }
+        chunk->shapes.push_back({name, at.triangles, 0});
+        break;
+      }
+      case Record::Object: {
+        const char *q = skip_space(line + 1, p), *e = p;
+        while (e > q && (is_space(e[-1]) || is_eol(e[-1]))) e--;
+        chunk->shapes.push_back({std::string(q, e), at.triangles, 0});
+        break;
+      }
+      default:
+        break;
+    }
+  }
+}
+
+/// @brief Split the quad of triangles t and t + 1 along its shorter
+///        diagonal, in float like tinyobj.
+void fix_quad(ObjData *obj, size_t t) {
+  int *idx = &obj->vertex_indices[3 * t];
+  // The fan wrote [0, 1, 2], [0, 2, 3].
+  int q[4] = {idx[0], idx[1], idx[2], idx[5]};
+  auto diagonal = [&](int a, int b) {
+    const Point3f &pa = obj->vertices[q[a]], &pb = obj->vertices[q[b]];
+    float dx = float(pb.x) - float(pa.x), dy = float(pb.y) - float(pa.y),
+          dz = float(pb.z) - float(pa.z);
+    return dx * dx + dy * dy + dz * dz;
+  };
+  if (diagonal(0, 2) < diagonal(1, 3)) return;
+  // [0, 1, 3], [1, 2, 3].
+  static const int kSplit[6] = {0, 1, 3, 1, 2, 3};
+  auto remap = [&](std::vector<int> *indices) {
+    if (indices->empty()) return;
+    int *i = &(*indices)[3 * t];
+    int c[4] = {i[0], i[1], i[2], i[5]};
+    for (int j = 0; j < 6; j++) i[j] = c[kSplit[j]];
+  };
+  remap(&obj->vertex_indices);
+  remap(&obj->normal_indices);
+  remap(&obj->uv_indices);
+}
+}  // namespace
+
+bool parse_obj(const char *filename, ObjData *obj, std::string *error,
+               int n_threads) {
+  MappedFile file;
+  if (!file.open(filename)) {
+    *error = "Can not read " + std::string(filename);
+    return false;
+  }
+  const char *data = reinterpret_cast<const char *>(file.data());
+  size_t size = file.size();
+  // Split on line boundaries. Inside a parallel_for the chunks would run
+  // serially anyway, so keep one.
+  if (in_parallel_for) n_threads = 1;
+  if (n_threads <= 0) n_threads = n_system_threads();
+  int n_chunks = int(std::min<size_t>(n_threads, size / kMinChunkBytes + 1));
+  std::vector<Chunk> chunks(n_chunks);
+  const char *begin = data, *end = data + size;
+  for (int i = 0; i < n_chunks; i++) {
+    chunks[i].begin = begin;
+    const char *split = data + size * (i + 1) / n_chunks;
+    begin = i + 1 == n_chunks ? end : next_line(std::max(begin, split), end);
+    chunks[i].end = begin;
+  }
+  // Count, then size everything.
+  parallel_for(
+      n_chunks, [&](int64_t i) { count_chunk(&chunks[i]); }, n_chunks);
+  ChunkCounts total;
+  for (Chunk &chunk : chunks) {
+    chunk.base = total;
+    total.vertices += chunk.count.vertices;
+    total.normals += chunk.count.normals;
+    total.uvs += chunk.count.uvs;
+    total.triangles += chunk.count.triangles;
+    total.lines += chunk.count.lines;
+  }
+  if (total.vertices > size_t(std::numeric_limits<int>::max()) ||
+      3 * total.triangles > size_t(std::numeric_limits<int>::max())) {
+    *error = "Too many vertices or triangles in " + std::string(filename);
+    return false;
+  }
+  obj->vertices.assign(total.vertices, Point3f());
+  obj->normals.assign(total.normals, Normal3f());
+  obj->uvs.assign(total.uvs, Point2f());
+  obj->vertex_indices.assign(3 * total.triangles, 0);
+  obj->normal_indices.assign(total.normals ? 3 * total.triangles : 0, -1);
+  obj->uv_indices.assign(total.uvs ? 3 * total.triangles : 0, -1);
+  // Parse in place.
+  parallel_for(
+      n_chunks, [&](int64_t i) { parse_chunk(&chunks[i], total, obj); },
+      n_chunks);
+  for (const Chunk &chunk : chunks) {
+    if (!chunk.error.empty()) {
+      *error = chunk.error;
+      return false;
+    }
+  }
+  parallel_for(
+      n_chunks,
+      [&](int64_t i) {
+        for (size_t t : chunks[i].quads) fix_quad(obj, t);
+      },
+      n_chunks);
+  // Drop the attribute indices nobody refers to.
+  bool normal_refs = false, uv_refs = false;
+  for (const Chunk &chunk : chunks) {
+    normal_refs |= chunk.has_normal_refs;
+    uv_refs |= chunk.has_uv_refs;
+  }
+  if (!normal_refs) obj->normal_indices = std::vector<int>();
+  if (!uv_refs) obj->uv_indices = std::vector<int>();
+  // Shapes start at g and o records.
+  obj->shapes.clear();
+  std::vector<ObjShape> starts = {{"", 0, 0}};
+  for (Chunk &chunk : chunks)
+    for (ObjShape &s : chunk.shapes) starts.push_back(std::move(s));
+  for (size_t i = 0; i < starts.size(); i++) {
+    size_t next = i + 1 < starts.size() ? starts[i + 1].first_triangle
+                                        : total.triangles;
+    starts[i].n_triangles = next - starts[i].first_triangle;
+    if (starts[i].n_triangles > 0) obj->shapes.push_back(std::move(starts[i]));
+  }
+  return true;
+}
+}  // namespace TRay
\ No newline at end of file
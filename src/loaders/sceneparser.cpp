@@ -0,0 +1,258 @@
+#include "loaders/sceneparser.h"
+
+#include <fstream>
+#include <nlohmann/json.hpp>
+
+#include "core/stringformat.h"
+#include "loaders/KeyVal.h"
+
+namespace TRay {
+using json = nlohmann::json;
+namespace {
+/// @brief Diverted array being read.
+enum class Target { None, Vertex, Index };
+
+/// @brief Top level entries that do not define the world.
+bool is_view_key(const std::string &key) {
+  return key == Key::Camera || key == Key::Sampler || key == Key::Integrator ||
+         key == Key::Snapshot;
+}
+
+/**
+ * @brief Forwards every event to a DOM builder, except those of the
+ *        diverted arrays.
+ *        In the first pass the diverted arrays are only counted, and the
+ *        world content is hashed. In the filling pass there is no DOM, the
+ *        diverted arrays are written into meshes sized by the counts.
+ */
+class SceneSax : public nlohmann::json_sax<json> {
+ public:
+  /// @brief First pass.
+  SceneSax(json *scene, std::vector<std::pair<size_t, size_t>> *counts,
+           uint64_t *hash)
+      : m_dom(new nlohmann::detail::json_sax_dom_parser<json>(*scene, false)),
+        m_counts(counts),
+        m_hash(hash) {
+    *m_hash = 14695981039346656037ull;
+  }
+  /// @brief Filling pass.
+  explicit SceneSax(std::vector<MeshData> *meshes) : m_meshes(meshes) {}
+  const std::string &error() const { return m_error; }
+
+  bool null() override {
+    if (m_target != Target::None) return fail("Expected a number");
+    element();
+    mix('n', nullptr, 0);
+    return !m_dom || m_dom->null();
+  }
+  bool boolean(bool val) override {
+    if (m_target != Target::None) return fail("Expected a number");
+    element();
+    mix('b', &val, sizeof(val));
+    return !m_dom || m_dom->boolean(val);
+  }
+  bool number_integer(number_integer_t val) override {
+    if (m_target != Target::None) return number(Float(val));
+    element();
+    mix('i', &val, sizeof(val));
+    return !m_dom || m_dom->number_integer(val);
+  }
+  bool number_unsigned(number_unsigned_t val) override {
+    if (m_target != Target::None) return number(Float(val));
+    element();
+    mix('u', &val, sizeof(val));
+    return !m_dom || m_dom->number_unsigned(val);
+  }
+  bool number_float(number_float_t val, const string_t &s) override {
+    if (m_target != Target::None) return number(Float(val));
+    element();
+    mix('f', &val, sizeof(val));
+    return !m_dom || m_dom->number_float(val, s);
+  }
+  bool string(string_t &val) override {
+    if (m_target != Target::None) return fail("Expected a number");
+    element();
+    mix('s', val.data(), val.size());
+    return !m_dom || m_dom->string(val);
+  }
+  bool binary(binary_t &val) override {
+    if (m_target != Target::None) return fail("Expected a number");
+    element();
+    mix('x', val.data(), val.size());
+    return !m_dom || m_dom->binary(val);
+  }
+  bool start_object(std::size_t elements) override {
+    if (m_target != Target::None) return fail("Expected a number");
+    element();
+    mix('{', nullptr, 0);
+    m_path.push_back({false, "", 0});
+    return !m_dom || m_dom->start_object(elements);
+  }
+  bool key(string_t &val) override {
+    m_path.back().key = val;
+    mix('k', val.data(), val.size());
+    return !m_dom || m_dom->key(val);
+  }
+  bool end_object() override {
+    m_path.pop_back();
+    mix('}', nullptr, 0);
+    return !m_dom || m_dom->end_object();
+  }
+  bool start_array(std::size_t elements) override {
+    if (m_target == Target::Vertex && !m_in_vertex) {
+      m_in_vertex = true;
+      m_component = 0;
+      return true;
+    }
+    if (m_target != Target::None) return fail("Expected a number");
+    // shapes[i].vertex or shapes[i].index.
+    if (m_path.size() == 3 && !m_path[0].is_array &&
+        m_path[0].key == Key::Shapes && m_path[1].is_array &&
+        !m_path[2].is_array &&
+        (m_path[2].key == Key::Vertex || m_path[2].key == Key::Index)) {
+      m_target = m_path[2].key == Key::Vertex ? Target::Vertex : Target::Index;
+      m_shape = m_path[1].n_elements - 1;
+      m_n = 0;
+      // The DOM keeps a null in its place.
+      return !m_dom || m_dom->null();
+    }
+    element();
+    mix('[', nullptr, 0);
+    m_path.push_back({true, "", 0});
+    return !m_dom || m_dom->start_array(elements);
+  }
+  bool end_array() override {
+    if (m_in_vertex) {
+      if (m_component != 3) return fail("Expected 3 coordinates");
+      m_in_vertex = false;
+      m_n++;
+      return true;
+    }
+    if (m_target != Target::None) return end_target();
+    m_path.pop_back();
+    mix(']', nullptr, 0);
+    return !m_dom || m_dom->end_array();
+  }
+  bool parse_error(std::size_t /*position*/, const std::string & /*last_token*/,
+                   const nlohmann::detail::exception &ex) override {
+    m_error = ex.what();
+    return false;
+  }
+
+ private:
+  struct Frame {
+    bool is_array;
+    std::string key;
+    size_t n_elements;
+  };
+  /// @brief A value starts in the current container.
+  void element() {
+    if (!m_path.empty() && m_path.back().is_array) m_path.back().n_elements++;
+  }
+  bool fail(const char *what) {
+    m_error = string_format("%s in shapes[%d].%s.", what, int(m_shape),
+                            m_target == Target::Vertex ? Key::Vertex.c_str()
+                                                       : Key::Index.c_str());
+    return false;
+  }
+  /// @brief Hash an event of type @param tag, unless it belongs to a view
+  ///        entry.
+  void mix(char tag, const void *data, size_t size) {
+    if (!m_hash || (!m_path.empty() && is_view_key(m_path[0].key))) return;
+    uint64_t h = *m_hash;
+    h = (h ^ uint8_t(tag)) * 1099511628211ull;
+    const uint8_t *bytes = static_cast<const uint8_t *>(data);
+    for (size_t i = 0; i < size; i++) h = (h ^ bytes[i]) * 1099511628211ull;
+    *m_hash = h;
+  }
+  bool number(Float val) {
+    mix('d', &val, sizeof(val));
+    if (m_target == Target::Vertex) {
+      if (!m_in_vertex) return fail("Expected an array of 3 coordinates");
+      if (m_component == 3) return fail("Expected 3 coordinates");
+      if (m_meshes) {
+        if (m_shape >= m_meshes->size()) return fail("Changed while reading");
+        std::vector<Point3f> &vertices = (*m_meshes)[m_shape].vertices;
+        if (m_n >= vertices.size()) return fail("Changed while reading");
+        vertices[m_n][m_component] = val;
+      }
+      m_component++;
+      return true;
+    }
+    if (m_meshes) {
+      if (m_shape >= m_meshes->size()) return fail("Changed while reading");
+      std::vector<int> &indices = (*m_meshes)[m_shape].indices;
+      if (m_n >= indices.size()) return fail("Changed while reading");
+      indices[m_n] = int(val);
+    }
+    m_n++;
+    return true;
+  }
+  bool end_target() {
+    if (m_meshes) {
+      if (m_shape >= m_meshes->size()) return fail("Changed while reading");
+      MeshData &mesh = (*m_meshes)[m_shape];
+      if (m_n != (m_target == Target::Vertex ? mesh.vertices.size()
+                                             : mesh.indices.size()))
+        return fail("Changed while reading");
+    }
+    if (m_counts) {
+      if (m_counts->size() <= m_shape) m_counts->resize(m_shape + 1);
+      auto &count = (*m_counts)[m_shape];
+      (m_target == Target::Vertex ? count.first : count.second) = m_n;
+    }
+    m_target = Target::None;
+    return true;
+  }
+
+  // First pass.
+  std::unique_ptr<nlohmann::detail::json_sax_dom_parser<json>> m_dom;
+  std::vector<std::pair<size_t, size_t>> *m_counts = nullptr;
+  uint64_t *m_hash = nullptr;
+  // Filling pass.
+  std::vector<MeshData> *m_meshes = nullptr;
+
+  std::vector<Frame> m_path;
+  Target m_target = Target::None;
+  size_t m_shape = 0;
+  // Elements read in the diverted array.
+  size_t m_n = 0;
+  bool m_in_vertex = false;
+  int m_component = 0;
+  std::string m_error;
+};
+}  // namespace
+
+bool SceneFileParser::parse(const std::string &path, json *scene,
+                            std::string *error) {
+  m_path = path;
+  m_counts.clear();
+  std::ifstream f(path, std::ios::binary);
+  if (!f) {
+    *error = "Failed to open scene file";
+    return false;
+  }
+  SceneSax sax(scene, &m_counts, &m_world_hash);
+  if (!json::sax_parse(f, &sax)) {
+    *error = sax.error();
+    return false;
+  }
+  return true;
+}
+bool SceneFileParser::read_inline_meshes(std::vector<MeshData> *meshes,
+                                         std::string *error) {
+  meshes->clear();
+  meshes->resize(m_counts.size());
+  for (size_t i = 0; i < m_counts.size(); i++) {
+    (*meshes)[i].vertices.resize(m_counts[i].first);
+    (*meshes)[i].indices.resize(m_counts[i].second);
+  }
+  std::ifstream f(m_path, std::ios::binary);
+  SceneSax sax(meshes);
+  if (!f || !json::sax_parse(f, &sax)) {
+    *error = f ? sax.error() : "Failed to open scene file";
+    return false;
+  }
+  return true;
+}
+}  // namespace TRay
\ No newline at end of file
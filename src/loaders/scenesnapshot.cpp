@@ -0,0 +1,86 @@
+#include "loaders/scenesnapshot.h"
+
+namespace TRay {
+static const char kSnapshotMagic[4] = {'T', 'R', 'S', 'S'};
+static constexpr uint32_t kSnapshotVersion = 2;
+
+std::string SceneSnapshot::snapshot_path(const std::string &scene_path) {
+  return scene_path + ".trsnap";
+}
+uint64_t SceneSnapshot::key(uint64_t world_hash,
+                            const std::vector<std::string> &files) {
+  uint64_t h = world_hash;
+  auto mix = [&](const void *data, size_t size) {
+    const uint8_t *bytes = static_cast<const uint8_t *>(data);
+    for (size_t i = 0; i < size; i++) h = (h ^ bytes[i]) * 1099511628211ull;
+  };
+  for (const std::string &file : files) {
+    uint64_t size = 0;
+    int64_t mtime = 0;
+    file_identity(file, &size, &mtime);
+    mix(file.data(), file.size());
+    mix(&size, sizeof(size));
+    mix(&mtime, sizeof(mtime));
+  }
+  return h;
+}
+bool SceneSnapshot::open(const std::string &scene_path, uint64_t key) {
+  close();
+  std::string path = snapshot_path(scene_path);
+  if (!m_file.open(path)) return false;
+  auto fail = [&](const std::string &why) {
+    SInfo("SceneSnapshot:: Ignoring " + path + ", " + why);
+    close();
+    return false;
+  };
+  if (m_file.size() < sizeof(SceneSnapshotHeader)) return fail("truncated");
+  const SceneSnapshotHeader *header =
+      reinterpret_cast<const SceneSnapshotHeader *>(m_file.data());
+  if (memcmp(header->magic, kSnapshotMagic, 4) != 0 ||
+      header->version != kSnapshotVersion ||
+      header->float_size != sizeof(Float))
+    return fail("different format");
+  if (header->key != key) return fail("scene changed");
+  uint64_t owners_end = sizeof(SceneSnapshotHeader) +
+                        uint64_t(header->n_shapes) * sizeof(uint32_t);
+  if (header->table_offset < owners_end ||
+      !view(m_file, header->table_offset, header->n_shapes))
+    return fail("truncated");
+  m_owners = reinterpret_cast<const uint32_t *>(m_file.data() +
+                                                sizeof(SceneSnapshotHeader));
+  SInfo("SceneSnapshot:: Loaded " + path);
+  return true;
+}
+void SceneSnapshot::close() {
+  clear_view();
+  m_owners = nullptr;
+  m_file.close();
+}
+
+bool SceneSnapshot::write(const std::string &scene_path, uint64_t key,
+                          const std::vector<uint32_t> &owners,
+                          const std::vector<MeshData> &meshes) {
+  SceneSnapshotHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, kSnapshotMagic, 4);
+  header.version = kSnapshotVersion;
+  header.float_size = sizeof(Float);
+  header.n_shapes = uint32_t(meshes.size());
+  header.key = key;
+  // Table 16-byte aligned after the owners.
+  header.table_offset =
+      (sizeof(header) + owners.size() * sizeof(uint32_t) + 15) / 16 * 16;
+  std::vector<MeshCacheShape> table;
+  uint64_t size = MeshBlocks::layout(meshes, header.table_offset, &table);
+  std::vector<uint8_t> image(size, 0);
+  memcpy(image.data(), &header, sizeof(header));
+  if (!owners.empty())
+    memcpy(image.data() + sizeof(header), owners.data(),
+           owners.size() * sizeof(uint32_t));
+  MeshBlocks::fill(meshes, header.table_offset, table, image.data());
+  std::string path = snapshot_path(scene_path);
+  if (!write_file_replacing(path, image.data(), image.size())) return false;
+  SInfo("SceneSnapshot:: Wrote " + path);
+  return true;
+}
+}  // namespace TRay
\ No newline at end of file
@@ -1,7 +1,6 @@
 #include "samplers/HaltonSampler.h"
 
-#include "core/math/lowdiscrepancy.h"
-
+#include "core/math/RNG.h"
 
 namespace TRay {
 /// @brief Solve x, y for ax + by = 1.
@@ -24,7 +23,8 @@ static uint64_t multiply_inverse(int64_t a, int64_t n) {
   exgcd(a, n, &x, &y);
   return mod(x, n);
 }
-HaltonSampler::HaltonSampler(int spp, const Bound2i &sample_bound)
+HaltonSampler::HaltonSampler(int spp, const Bound2i &sample_bound,
+                             bool scramble)
     : GlobalSampler(spp) {
   // Scaling to map the first 2 dims to pixel position.
   Vector2i reso = sample_bound.p_max - sample_bound.p_min;
@@ -43,6 +43,31 @@ HaltonSampler::HaltonSampler(int spp, const Bound2i &sample_bound)
   // Multiplicetive inverse for determine the first global index using CRT.
   m_mult_inv[0] = multiply_inverse(m_scale_ceil[1], m_scale_ceil[0]);
   m_mult_inv[1] = multiply_inverse(m_scale_ceil[0], m_scale_ceil[1]);
+  /**
+   * X = i mod 2^m_scale_expo[0]
+   * Y = i mod 3^m_scale_expo[1]
+   * Use CRT to find the first solution.
+   * @see https://zhuanlan.zhihu.com/p/44591114
+   * In short: If a x = a_i (mod m_i) and every two m_i are co-prime,
+   *           Then x = sum{ a_i * N / m_i * inv(m_i) } (mod N),
+   *           where N = prod(m_i) and
+   *           inv(m_i) is the multiplicative inverse of N/m_i (mod m_i).
+   */
+  for (int p = 0; p < MAX_RESOLUTION; ++p) {
+    for (int i = 0; i < 2; ++i) {
+      // The integer part of scaled radical inverse.
+      uint64_t offset_in_dim = (i == 0)
+                                   ? radical_inverse_inv<2>(p, m_scale_expo[i])
+                                   : radical_inverse_inv<3>(p, m_scale_expo[i]);
+      m_pixel_offsets[i][p] = offset_in_dim *
+                              (m_sample_stride / m_scale_ceil[i]) *
+                              m_mult_inv[i] % m_sample_stride;
+    }
+  }
+  if (scramble) {
+    RNG rng;
+    m_permutations = std::make_shared<DigitPermutations>(rng);
+  }
   // SInfo(
   //     string_format("HaltonSampler:: Created halton sampler with"
   //                   "\n\tspp %d"
@@ -53,30 +78,11 @@ HaltonSampler::HaltonSampler(int spp, const Bound2i &sample_bound)
 }
 int64_t HaltonSampler::global_index(int64_t local_index) const {
   if (m_current_pixel != m_offset_pixel) {
-    /**
-     * X = i mod 2^m_scale_expo[0]
-     * Y = i mod 3^m_scale_expo[1]
-     * Use CRT to find the first solution.
-     * @see https://zhuanlan.zhihu.com/p/44591114
-     * In short: If a x = a_i (mod m_i) and every two m_i are co-prime,
-     *           Then x = sum{ a_i * N / m_i * inv(m_i) } (mod N),
-     *           where N = prod(m_i) and
-     *           inv(m_i) is the multiplicative inverse of N/m_i (mod m_i).
-     */
-    m_offset_global_idx = 0;
-    if (m_sample_stride > 1) {
-      Point2i pm(mod(m_current_pixel[0], MAX_RESOLUTION),
-                 mod(m_current_pixel[1], MAX_RESOLUTION));
-      for (int i = 0; i < 2; ++i) {
-        // The integer part of scaled radical inverse.
-        uint64_t offset_in_dim =
-            (i == 0) ? radical_inverse_inv<2>(pm[i], m_scale_expo[i])
-                     : radical_inverse_inv<3>(pm[i], m_scale_expo[i]);
-        m_offset_global_idx +=
-            offset_in_dim * (m_sample_stride / m_scale_ceil[i]) * m_mult_inv[i];
-      }
-      m_offset_global_idx %= m_sample_stride;
-    }
+    // See the constructor.
+    m_offset_global_idx =
+        (m_pixel_offsets[0][mod(m_current_pixel[0], MAX_RESOLUTION)] +
+         m_pixel_offsets[1][mod(m_current_pixel[1], MAX_RESOLUTION)]) %
+        m_sample_stride;
     m_offset_pixel = m_current_pixel;
   }
   return m_offset_global_idx + local_index * m_sample_stride;
@@ -87,6 +93,9 @@ Float HaltonSampler::value_by_dimension(int64_t global_idx_sample,
   if (idx_dim == 0 || idx_dim == 1)
     // Remove position-related digits and return the relative coord in a pixel.
     ret = radical_inverse(idx_dim, global_idx_sample / m_scale_ceil[idx_dim]);
+  else if (m_permutations)
+    ret = scrambled_radical_inverse(idx_dim, global_idx_sample,
+                                    *m_permutations);
   else
     ret = radical_inverse(idx_dim, global_idx_sample);
   return ret;
@@ -9,6 +9,11 @@ int64_t SobolSampler::global_index(int64_t local_index) const {
   return global_index_Sobol(m_scale_expo, local_index,
                               Point2i(relative.x, relative.y));
 }
+int64_t SobolSampler::next_global_index(int64_t global_idx,
+                                        int64_t local_index) const {
+  if (local_index >= (1ll << 32)) return global_index(local_index);
+  return global_idx ^ m_index_step[ctz(uint32_t(local_index))];
+}
 Float SobolSampler::value_by_dimension(int64_t global_idx_sample,
                                        int idx_dim) const {
   Float value = sample_Sobol(global_idx_sample, idx_dim);
@@ -19,4 +24,14 @@ Float SobolSampler::value_by_dimension(int64_t global_idx_sample,
   }
   return value;
 }
+void SobolSampler::values_by_dimension(int64_t global_idx_sample, int idx_dim,
+                                       int n, Float *values) const {
+  sample_Sobol(global_idx_sample, idx_dim, n, values);
+  // For pixel position.
+  for (int d = idx_dim; d < std::min(idx_dim + n, 2); d++) {
+    Float &value = values[d - idx_dim];
+    value = value * m_scale + m_sample_bound.p_min[d];
+    value = clamp(value - m_current_pixel[d], Float(0), ONE_M_EPS);
+  }
+}
 }  // namespace TRay
\ No newline at end of file
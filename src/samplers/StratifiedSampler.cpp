@@ -16,19 +16,17 @@ StratifiedSampler::StratifiedSampler(int x_num, int y_num, int num_dim,
   //       string_format("\n\tx strata %d, y strata %d, jitter %d", m_x_samples,
   //                     m_y_samples, m_jitter));
 }
-void StratifiedSampler::start_pixel(const Point2i &p) {
-  // Fill for sampling 1D.
-  for (size_t i = 0; i < m_sample_1D.size(); i++) {
-    fill_stratified_1D(&m_sample_1D[i][0], m_x_samples * m_y_samples, m_rng,
-                       m_jitter);
-    shuffle(&m_sample_1D[i][0], m_x_samples * m_y_samples, 1, m_rng);
-  }
-  // Fill for sampling 2D.
-  for (size_t i = 0; i < m_sample_2D.size(); i++) {
-    fill_stratified_2D(&m_sample_2D[i][0], m_x_samples, m_y_samples, m_rng,
-                       m_jitter);
-    shuffle(&m_sample_2D[i][0], m_x_samples * m_y_samples, 1, m_rng);
-  }
+void StratifiedSampler::fill_1D(int dim) {
+  fill_stratified_1D(&m_sample_1D[dim][0], m_x_samples * m_y_samples, m_rng,
+                     m_jitter);
+  shuffle(&m_sample_1D[dim][0], m_x_samples * m_y_samples, 1, m_rng);
+}
+void StratifiedSampler::fill_2D(int dim) {
+  fill_stratified_2D(&m_sample_2D[dim][0], m_x_samples, m_y_samples, m_rng,
+                     m_jitter);
+  shuffle(&m_sample_2D[dim][0], m_x_samples * m_y_samples, 1, m_rng);
+}
+void StratifiedSampler::fill_arrays() {
   // Fill for sampling 1D array.
   for (size_t i = 0; i < m_1D_array_sizes.size(); i++) {
     int n = m_1D_array_sizes[i];
@@ -63,7 +61,6 @@ void StratifiedSampler::start_pixel(const Point2i &p) {
       }
     }
   }
-  PixelSampler::start_pixel(p);
 }
 std::unique_ptr<Sampler> StratifiedSampler::clone(int seed) const {
   StratifiedSampler *ss = new StratifiedSampler(*this);
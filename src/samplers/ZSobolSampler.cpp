@@ -0,0 +1,95 @@
+#include "samplers/ZSobolSampler.h"
+
+#include "core/math/lowdiscrepancy.h"
+
+namespace TRay {
+/// @brief Spread the lower 32 bits of @param v to every other bit.
+static uint64_t left_shift2(uint64_t v) {
+  v &= 0xffffffff;
+  v = (v | (v << 16)) & 0x0000ffff0000ffff;
+  v = (v | (v << 8)) & 0x00ff00ff00ff00ff;
+  v = (v | (v << 4)) & 0x0f0f0f0f0f0f0f0f;
+  v = (v | (v << 2)) & 0x3333333333333333;
+  v = (v | (v << 1)) & 0x5555555555555555;
+  return v;
+}
+/// @brief Seed of the scrambles of dimension @param idx_dim.
+static uint64_t dimension_hash(int idx_dim, uint32_t seed) {
+  return mix_bits((uint64_t(idx_dim) << 32) | seed);
+}
+static Float to_unit(uint32_t v) {
+  return std::min(v * Float(0x1p-32), ONE_M_EPS);
+}
+
+ZSobolSampler::ZSobolSampler(int64_t spp, const Bound2i &sample_bound,
+                             uint32_t seed)
+    : GlobalSampler(round(spp)), m_sample_bound(sample_bound), m_seed(seed) {
+  m_log2_spp = log2_int(uint32_t(m_spp));
+  int res = pow2_ceil(
+      std::max(sample_bound.diagonal().x, sample_bound.diagonal().y));
+  m_log2_res = log2_int(uint32_t(res));
+  set_log2_samples(m_log2_spp);
+}
+void ZSobolSampler::set_log2_samples(int log2_samples) {
+  m_log2_samples = log2_samples;
+  m_n_base4_digits = m_log2_res + (m_log2_samples + 1) / 2;
+}
+void ZSobolSampler::start_pixel(const Point2i &p) {
+  // Arrays take n * spp local indices, which must stay in the pixel.
+  int max_array = 1;
+  for (int n : m_1D_array_sizes) max_array = std::max(max_array, n);
+  for (int n : m_2D_array_sizes) max_array = std::max(max_array, n);
+  int log2_samples = m_log2_spp + log2_int(uint32_t(pow2_ceil(max_array)));
+  if (log2_samples != m_log2_samples) set_log2_samples(log2_samples);
+  GlobalSampler::start_pixel(p);
+}
+int64_t ZSobolSampler::global_index(int64_t local_index) const {
+  Vector2i p = m_current_pixel - m_sample_bound.p_min;
+  uint64_t morton = (left_shift2(p.y) << 1) | left_shift2(p.x);
+  return (morton << m_log2_samples) + local_index;
+}
+uint64_t ZSobolSampler::sample_index(uint64_t morton_idx, int idx_dim) const {
+  static constexpr uint8_t permutations[24][4] = {
+      {0, 1, 2, 3}, {0, 1, 3, 2}, {0, 2, 1, 3}, {0, 2, 3, 1}, {0, 3, 2, 1},
+      {0, 3, 1, 2}, {1, 0, 2, 3}, {1, 0, 3, 2}, {1, 2, 0, 3}, {1, 2, 3, 0},
+      {1, 3, 2, 0}, {1, 3, 0, 2}, {2, 1, 0, 3}, {2, 1, 3, 0}, {2, 0, 1, 3},
+      {2, 0, 3, 1}, {2, 3, 0, 1}, {2, 3, 1, 0}, {3, 1, 2, 0}, {3, 1, 0, 2},
+      {3, 2, 1, 0}, {3, 2, 0, 1}, {3, 0, 2, 1}, {3, 0, 1, 2}};
+  // With an odd power of 2 samples, the last digit is a single bit.
+  bool odd = m_log2_samples & 1;
+  uint64_t dim_bits = 0x55555555u * uint64_t(idx_dim);
+  uint64_t index = 0;
+  // Each digit is permuted by a hash of the higher ones, so that the pixels
+  // of every quad of a level get all 4 digits.
+  for (int i = m_n_base4_digits - 1; i >= int(odd); --i) {
+    int shift = 2 * i - int(odd);
+    int digit = (morton_idx >> shift) & 3;
+    uint64_t higher = morton_idx >> (shift + 2);
+    int p = (mix_bits(higher ^ dim_bits) >> 24) % 24;
+    index |= uint64_t(permutations[p][digit]) << shift;
+  }
+  if (odd) {
+    int digit = morton_idx & 1;
+    index |= digit ^ (mix_bits((morton_idx >> 1) ^ dim_bits) & 1);
+  }
+  return index;
+}
+Float ZSobolSampler::value_by_dimension(int64_t global_idx_sample,
+                                        int idx_dim) const {
+  uint64_t index = sample_index(global_idx_sample, idx_dim);
+  uint32_t seed = uint32_t(dimension_hash(idx_dim, m_seed));
+  return to_unit(owen_scramble(Sobol_bits32(index, 0), seed));
+}
+void ZSobolSampler::values_by_dimension(int64_t global_idx_sample, int idx_dim,
+                                        int n, Float *values) const {
+  if (n != 2) {
+    GlobalSampler::values_by_dimension(global_idx_sample, idx_dim, n, values);
+    return;
+  }
+  uint64_t index = sample_index(global_idx_sample, idx_dim);
+  uint64_t seed = dimension_hash(idx_dim, m_seed);
+  values[0] = to_unit(owen_scramble(Sobol_bits32(index, 0), uint32_t(seed)));
+  values[1] =
+      to_unit(owen_scramble(Sobol_bits32(index, 1), uint32_t(seed >> 32)));
+}
+}  // namespace TRay
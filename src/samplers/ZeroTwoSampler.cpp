@@ -2,22 +2,33 @@
 #include "core/math/lowdiscrepancy.h"
 
 namespace TRay {
-void ZeroTwoSampler::start_pixel(const Point2i &p) {
-  // Single RNG, samples will change with #dimensions.
-  // 1D
-  for (size_t i = 0; i < m_sample_1D.size(); i++)
-    fill_VDCorput_1D(1, m_spp, &m_sample_1D[i][0], m_rng);
-  // 2D
-  for (size_t i = 0; i < m_sample_2D.size(); i++)
-    fill_Sobol_2D(1, m_spp, &m_sample_2D[i][0], m_rng);
+void ZeroTwoSampler::reserve_dimensions(const SampleDimensions &dims) {
+  PixelSampler::reserve_dimensions(dims);
+  // The arrays are requested by now, size the table before it is cloned.
+  int n_max = 1;
+  for (int n : m_1D_array_sizes) n_max = std::max(n_max, n);
+  for (int n : m_2D_array_sizes) n_max = std::max(n_max, n);
+  fit_table(m_table, n_max * m_spp);
+}
+void ZeroTwoSampler::fill_1D(int dim) {
+  fill_VDCorput_1D(1, m_spp, *m_table, &m_sample_1D[dim][0], m_rng);
+}
+void ZeroTwoSampler::fill_2D(int dim) {
+  fill_Sobol_2D(1, m_spp, *m_table, &m_sample_2D[dim][0], m_rng);
+}
+void ZeroTwoSampler::fill_arrays() {
+  // Single RNG, samples will change with the dimensions used.
   // 1D array
-  for (size_t i = 0; i < m_1D_array_sizes.size(); i++)
-    fill_VDCorput_1D(m_1D_array_sizes[i], m_spp, &m_sample_1D_array[i][0],
-                     m_rng);
+  for (size_t i = 0; i < m_1D_array_sizes.size(); i++) {
+    fit_table(m_table, m_1D_array_sizes[i] * m_spp);
+    fill_VDCorput_1D(m_1D_array_sizes[i], m_spp, *m_table,
+                     &m_sample_1D_array[i][0], m_rng);
+  }
   // 2D array
-  for (size_t i = 0; i < m_2D_array_sizes.size(); i++)
-    fill_Sobol_2D(m_2D_array_sizes[i], m_spp, &m_sample_2D_array[i][0], m_rng);
-
-  PixelSampler::start_pixel(p);
+  for (size_t i = 0; i < m_2D_array_sizes.size(); i++) {
+    fit_table(m_table, m_2D_array_sizes[i] * m_spp);
+    fill_Sobol_2D(m_2D_array_sizes[i], m_spp, *m_table,
+                  &m_sample_2D_array[i][0], m_rng);
+  }
 }
 }  // namespace TRay
\ No newline at end of file
@@ -7,6 +7,11 @@ Bound3f Sphere::object_bound() const {
   return Bound3f(Point3f(-radius, -radius, z_min),
                  Point3f(radius, radius, z_max));
 }
+Bound3f Sphere::world_bound() const {
+  if (!world_space) return Shape::world_bound();
+  Vector3f r(world_radius, world_radius, world_radius);
+  return Bound3f(world_center - r, world_center + r);
+}
 /**
  * Some points in doing intersection:
  *  1. Intersection after ray.t_max is ignored.
@@ -15,33 +20,56 @@ Bound3f Sphere::object_bound() const {
  *  4. Ray is in world space, but intersection test is easier in object space,
  *     and the return interaction info should be in world space.
  */
-bool Sphere::intersect(const Ray &ray, Float *t, SurfaceInteraction *si,
-                       bool) const {
-  // SDebug("Sphere::intersect: testing ray " + ray.to_string());
-  // SDebug("\twith sphere at " + obj_to_world(Point3f(0, 0, 0)).to_string() +
-  //        ", radius " + format_one("%f ", radius));
-  Float phi = 0;
-  Point3f p_hit;
-  // Ray to obj space.
-  Ray obj_ray = (*world_to_obj)(ray);
-  // PEEK(world_to_obj.to_string());
-  // Construct formula.
-  Float dx = obj_ray.dir.x, dy = obj_ray.dir.y, dz = obj_ray.dir.z;
-  Float ox = obj_ray.ori.x, oy = obj_ray.ori.y, oz = obj_ray.ori.z;
-  Float a = dx * dx + dy * dy + dz * dz;
-  Float b = 2 * (dx * ox + dy * oy + dz * oz);
-  Float c = ox * ox + oy * oy + oz * oz - radius * radius;
+bool Sphere::hit(const Ray &ray, Float *t, Point3f *p_obj) const {
+  // Origin and direction of the ray, relative to the sphere center, and the
+  // radius, all in the same space.
+  Vector3f o, d;
+  Float r;
+  if (world_space) {
+    o = ray.ori - world_center;
+    d = ray.dir;
+    r = world_radius;
+  } else {
+    // Ray to obj space.
+    Ray obj_ray = (*world_to_obj)(ray);
+    o = obj_ray.ori - Point3f(0, 0, 0);
+    d = obj_ray.dir;
+    r = radius;
+  }
+  // Construct formula. The parametric distance is the same in both spaces.
+  Float a = d.x * d.x + d.y * d.y + d.z * d.z;
+  Float b = 2 * (d.x * o.x + d.y * o.y + d.z * o.z);
+  Float c = o.x * o.x + o.y * o.y + o.z * o.z - r * r;
   // Solve formula.
   Float t0 = 0, t1 = 0;
   if (!solve_quadratic(a, b, c, &t0, &t1)) return false;
   // The time range.
-  if (t0 > obj_ray.t_max || t1 <= 0) return false;
+  if (t0 > ray.t_max || t1 <= 0) return false;
   Float t_hit = t0;
   if (t_hit <= 0) {
     t_hit = t1;
-    if (t_hit > obj_ray.t_max) return false;
+    if (t_hit > ray.t_max) return false;
   }
-  p_hit = obj_ray(t_hit);
+  *t = t_hit;
+  if (p_obj) {
+    Point3f p = Point3f(0, 0, 0) + o + d * t_hit;
+    *p_obj = world_space ? p * (1 / world_scale) : p;
+  }
+  return true;
+}
+bool Sphere::intersect_test(const Ray &ray, bool) const {
+  Float t_hit;
+  return hit(ray, &t_hit, nullptr);
+}
+bool Sphere::intersect(const Ray &ray, Float *t, SurfaceInteraction *si,
+                       bool) const {
+  // SDebug("Sphere::intersect: testing ray " + ray.to_string());
+  // SDebug("\twith sphere at " + obj_to_world(Point3f(0, 0, 0)).to_string() +
+  //        ", radius " + format_one("%f ", radius));
+  Float phi = 0, t_hit = 0;
+  Point3f p_hit;
+  if (!hit(ray, &t_hit, &p_hit)) return false;
+  // Surface details for the hit only.
   // Refine.
   // p_hit *= radius / distance(p_hit, Point3f(0, 0, 0));
   // Avoid 0 in following z_radius.
@@ -65,9 +93,23 @@ bool Sphere::intersect(const Ray &ray, Float *t, SurfaceInteraction *si,
       Vector3f(p_hit.z * cos_phi, p_hit.z * sin_phi, -radius * std::sin(theta));
   // Return values.
   if (t) *t = t_hit;
-  if (si)
+  if (!si) return true;
+  if (world_space) {
+    // As the full transform, but only scale and offset are needed. Results
+    // are bit-identical for power-of-2 scales, other scales round the radius
+    // and the hit point differently and may differ in the last bits.
+    *si = SurfaceInteraction(world_center + (p_hit - Point3f(0, 0, 0)) *
+                                                world_scale,
+                             Point2f(u, v), -ray.dir, dpdu * world_scale,
+                             dpdv * world_scale, ray.time, this);
+    // The transform normalizes these again.
+    si->n = normalize(si->n);
+    si->shading.n = normalize(si->shading.n);
+    si->wo = normalize(si->wo);
+  } else {
     *si = (*obj_to_world)(SurfaceInteraction(p_hit, Point2f(u, v), -ray.dir,
                                              dpdu, dpdv, ray.time, this));
+  }
   return true;
 }
 Interaction Sphere::sample_surface(const Point2f &u, Float *pdf_value) const {
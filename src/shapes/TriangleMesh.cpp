@@ -7,6 +7,7 @@
 #include "core/math/sampling.h"
 
 namespace TRay {
+STAT_MEMORY("Memory/triangle_mesh", mesh_memory);
 TriangleMesh::TriangleMesh(const Transform &obj_to_world, int _n_triangles,
                            const int *vertex_indices, int _n_vertices,
                            const Point3f *vertices,
@@ -14,7 +15,12 @@ TriangleMesh::TriangleMesh(const Transform &obj_to_world, int _n_triangles,
                            const Point2f *vertex_uv)
     : n_triangles(_n_triangles),
       n_vertices(_n_vertices),
-      vindex(vertex_indices, vertex_indices + 3 * _n_triangles) {
+      memory(&mesh_memory) {
+  // Compact index buffer.
+  if (_n_vertices <= std::numeric_limits<uint16_t>::max() + 1)
+    vindex16.assign(vertex_indices, vertex_indices + 3 * _n_triangles);
+  else
+    vindex32.assign(vertex_indices, vertex_indices + 3 * _n_triangles);
   // Point3f* vertices.
   vpos.reset(new Point3f[_n_vertices]);
   for (int i = 0; i < _n_vertices; i++) vpos[i] = obj_to_world(vertices[i]);
@@ -29,6 +35,10 @@ TriangleMesh::TriangleMesh(const Transform &obj_to_world, int _n_triangles,
     vuv.reset(new Point2f[_n_vertices]);
     memcpy(vuv.get(), vertex_uv, _n_vertices * sizeof(Point2f));
   }
+  memory.set(vindex16.size() * sizeof(uint16_t) +
+             vindex32.size() * sizeof(uint32_t) +
+             _n_vertices * (sizeof(Point3f) + (vnormal ? sizeof(Normal3f) : 0) +
+                            (vuv ? sizeof(Point2f) : 0)));
 }
 
 Triangle::Triangle(const Transform &obj_world, const Transform &world_obj,
@@ -37,14 +47,14 @@ Triangle::Triangle(const Transform &obj_world, const Transform &world_obj,
                    int triangle_index)
     : Shape(obj_world, world_obj, _flip_normal),
       m_parent_mesh(parent_mesh),
-      vidx(&(parent_mesh->vindex[3 * triangle_index])) {}
+      m_first_index(3 * triangle_index) {}
 Bound3f Triangle::object_bound() const {
   return (*world_to_obj)(world_bound());
 }
 Bound3f Triangle::world_bound() const {
-  const Point3f &p0 = m_parent_mesh->vpos[vidx[0]];
-  const Point3f &p1 = m_parent_mesh->vpos[vidx[1]];
-  const Point3f &p2 = m_parent_mesh->vpos[vidx[2]];
+  const Point3f &p0 = m_parent_mesh->vpos[vidx(0)];
+  const Point3f &p1 = m_parent_mesh->vpos[vidx(1)];
+  const Point3f &p2 = m_parent_mesh->vpos[vidx(2)];
   Bound3f bound = bound_insert(Bound3f(p0, p1), p2);
   // In case of axis-parallel triangle.
   bound.p_min -= Vector3f(0.01, 0.01, 0.01);
@@ -54,9 +64,9 @@ Bound3f Triangle::world_bound() const {
 bool Triangle::intersect(const Ray &ray, Float *thit, SurfaceInteraction *si,
                          bool) const {
   // Get triangle vertices.
-  const Point3f &p0 = m_parent_mesh->vpos[vidx[0]];
-  const Point3f &p1 = m_parent_mesh->vpos[vidx[1]];
-  const Point3f &p2 = m_parent_mesh->vpos[vidx[2]];
+  const Point3f &p0 = m_parent_mesh->vpos[vidx(0)];
+  const Point3f &p1 = m_parent_mesh->vpos[vidx(1)];
+  const Point3f &p2 = m_parent_mesh->vpos[vidx(2)];
 
   // Perform ray--triangle intersection test
 
@@ -204,18 +214,18 @@ bool Triangle::intersect(const Ray &ray, Float *thit, SurfaceInteraction *si,
 }
 Interaction Triangle::sample_surface(const Point2f &u, Float *pdf_value) const {
   Point2f bary = triangle_uniform_sample(u);
-  const Point3f &p0 = m_parent_mesh->vpos[vidx[0]];
-  const Point3f &p1 = m_parent_mesh->vpos[vidx[1]];
-  const Point3f &p2 = m_parent_mesh->vpos[vidx[2]];
+  const Point3f &p0 = m_parent_mesh->vpos[vidx(0)];
+  const Point3f &p1 = m_parent_mesh->vpos[vidx(1)];
+  const Point3f &p2 = m_parent_mesh->vpos[vidx(2)];
   Interaction inter;
   inter.p = bary[0] * p0 + bary[1] * p1 + (1 - bary[0] - bary[1]) * p2;
   inter.n = Normal3f(normalize(cross(p1 - p0, p2 - p0)));
   if (m_parent_mesh->vnormal) {
     // Geometric normal should stay with geometric representation.
     Normal3f shading_n =
-        normalize(bary[0] * m_parent_mesh->vnormal[vidx[0]] +
-                  bary[1] * m_parent_mesh->vnormal[vidx[1]] +
-                  (1 - bary[0] - bary[1]) * m_parent_mesh->vnormal[vidx[2]]);
+        normalize(bary[0] * m_parent_mesh->vnormal[vidx(0)] +
+                  bary[1] * m_parent_mesh->vnormal[vidx(1)] +
+                  (1 - bary[0] - bary[1]) * m_parent_mesh->vnormal[vidx(2)]);
     inter.n = align_with(inter.n, shading_n);
   } else if (flip_normal ^ swap_handness) {
     inter.n *= -1;
@@ -227,9 +237,9 @@ Interaction Triangle::sample_surface(const Point2f &u, Float *pdf_value) const {
   return inter;
 }
 Float Triangle::area() const {
-  const Point3f &p0 = m_parent_mesh->vpos[vidx[0]];
-  const Point3f &p1 = m_parent_mesh->vpos[vidx[1]];
-  const Point3f &p2 = m_parent_mesh->vpos[vidx[2]];
+  const Point3f &p0 = m_parent_mesh->vpos[vidx(0)];
+  const Point3f &p1 = m_parent_mesh->vpos[vidx(1)];
+  const Point3f &p2 = m_parent_mesh->vpos[vidx(2)];
   return 0.5 * cross(p1 - p0, p2 - p0).length();
 }
 